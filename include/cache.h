@@ -0,0 +1,10 @@
+#ifndef __PANDAA73_PI_CACHE_H
+#define __PANDAA73_PI_CACHE_H
+
+/*
+ * Kept out of emulator.h so that ring.h, which is also used by the processes
+ * on the other side of a channel, stays self-contained
+ */
+#define PI_CACHE_LINE 64
+
+#endif /* __PANDAA73_PI_CACHE_H */
@@ -0,0 +1,120 @@
+#ifndef __PANDAA73_PI_DEBUGGER_H
+#define __PANDAA73_PI_DEBUGGER_H
+
+#include "emulator.h"
+
+#include <stdint.h>
+
+enum pi_watch_t {
+    PIWCH_READ  = 0x01,
+    PIWCH_WRITE = 0x02,
+};
+
+enum pi_debug_event_kind_t {
+    PIDBG_BREAKPOINT,
+    PIDBG_MEM_READ,
+    PIDBG_MEM_WRITE,
+    PIDBG_PORT_READ,
+    PIDBG_PORT_WRITE,
+};
+
+enum pi_debug_action_t {
+    PIDBG_CONTINUE,
+    PIDBG_STOP,
+};
+
+struct pi_debug_event_t {
+    enum pi_debug_event_kind_t kind;
+
+    /* Address of the instruction about to be executed */
+    uint16_t inst_ptr;
+
+    /* Memory address or port number, unused for breakpoints */
+    uint8_t address;
+};
+
+struct pi_debugger_t;
+
+typedef enum pi_debug_action_t (*pi_debug_callback_t)(
+    struct pi_debugger_t *debugger,
+    const struct pi_debug_event_t *event,
+    void *userdata
+);
+
+struct pi_debugger_t {
+    struct pi_emulator_t *emulator;
+
+    pi_debug_callback_t callback;
+    void *userdata;
+
+    /* Number of armed breakpoints and watchpoints */
+    uint16_t armed;
+
+    /*
+     * Where the last stop happened, and how many of the points of that
+     * instruction were reported by then: none, its breakpoint only, or all of
+     * them. Resuming there skips those once, so that it does not hit the same
+     * point again, but still reports a watchpoint that the breakpoint stopped
+     * short of. Moving `inst_ptr` elsewhere in the meantime (jumping,
+     * resetting, loading a new program) reports the points as usual.
+     */
+    uint8_t reported;
+    uint16_t stopped_at;
+
+    /*
+     * Trap markers shadowing `emulator->program`, one per instruction, and
+     * watch masks (`enum pi_watch_t`) for every memory address and port
+     */
+    uint8_t traps[MAX_PROGRAM_LEN];
+    uint8_t mem_watch[MEMORY_LEN];
+    uint8_t port_watch[PORTS_LEN];
+};
+
+void pi_debugger_init(
+    struct pi_debugger_t *debugger,
+    struct pi_emulator_t *emulator
+);
+
+void pi_debugger_set_callback(
+    struct pi_debugger_t *debugger,
+    pi_debug_callback_t callback,
+    void *userdata
+);
+
+void pi_debugger_add_breakpoint(
+    struct pi_debugger_t *debugger,
+    uint16_t inst_ptr
+);
+void pi_debugger_remove_breakpoint(
+    struct pi_debugger_t *debugger,
+    uint16_t inst_ptr
+);
+
+void pi_debugger_add_mem_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t address,
+    uint8_t mode
+);
+void pi_debugger_remove_mem_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t address
+);
+
+void pi_debugger_add_port_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t port,
+    uint8_t mode
+);
+void pi_debugger_remove_port_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t port
+);
+
+/*
+ * Runs the emulator until it halts or the callback returns `PIDBG_STOP`.
+ * Returns non-zero if execution was stopped by the callback. While no point
+ * is armed this is the regular `pi_emulator_execute` loop.
+ */
+int pi_debugger_execute(struct pi_debugger_t *debugger);
+
+#endif /* __PANDAA73_PI_DEBUGGER_H */
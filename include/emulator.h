@@ -1,6 +1,9 @@
 #ifndef __PANDAA73_PI_EMULATOR_H
 #define __PANDAA73_PI_EMULATOR_H
 
+#include "cache.h"
+
+#include <stdatomic.h>
 #include <stdint.h>
 
 #define REGISTERS_LEN   8
@@ -65,38 +68,109 @@ enum pi_opcode_t {
     PIOP_SIZE
 };
 
+struct pi_channel_t;
+
 struct pi_port_t {
     uint8_t (*reader)(void);
     void (*writer)(uint8_t);
 };
 
+/*
+ * Summary of the load-time analysis of a program, see verifier.c. Verified
+ * programs run without range checks on `inst_ptr` and `callstack_ptr` nor
+ * guards on register writes.
+ */
+struct pi_proof_t {
+    uint8_t verified;
+    uint8_t max_call_depth;
+
+    /* First offending instruction when not verified */
+    uint16_t failed_at;
+
+    /* Bitmap of the instructions reachable outside of any call */
+    uint64_t toplevel[MAX_PROGRAM_LEN / 64];
+};
+
+/*
+ * Runtime counters of an emulator, written by the thread running it and read
+ * by `pi_metrics_snapshot` from any thread, see metrics.h. Instructions
+ * retired are only published in batches while executing.
+ */
+struct pi_metrics_t {
+    _Atomic uint64_t retired;
+    _Atomic uint64_t halts;
+    _Atomic uint64_t random_bytes;
+
+    _Atomic uint64_t port_reads[PORTS_LEN];
+    _Atomic uint64_t port_writes[PORTS_LEN];
+    _Atomic uint64_t port_callback_ns[PORTS_LEN];
+
+    /* Links in the list of attached emulators, valid while `attached` is set */
+    uint8_t attached;
+    struct pi_metrics_t *prev;
+    struct pi_metrics_t *next;
+};
+
 struct pi_emulator_t {
+    /* Hot state, kept together in the first cache line */
     uint8_t flags;
     uint8_t regs[REGISTERS_LEN];
+    uint8_t blocking_channels;
+
+    uint16_t inst_ptr;
+    uint16_t callstack_ptr;
+
+    int urandom_fd;
+
+    uint16_t callstack[CALLSTACK_LEN];
 
     uint8_t mem[MEMORY_LEN];
     struct pi_port_t ports[PORTS_LEN];
 
-    uint16_t callstack_ptr;
-    uint16_t callstack[CALLSTACK_LEN];
+    /* Shared memory channels take precedence over `ports` when bound */
+    struct pi_channel_t *channels[PORTS_LEN];
 
-    uint16_t inst_ptr;
     uint16_t program[MAX_PROGRAM_LEN];
-
-    int urandom_fd;
+    struct pi_proof_t proof;
+    struct pi_metrics_t metrics;
 };
 
 void pi_emulator_init(struct pi_emulator_t *emulator);
+
+/*
+ * Clears the execution state (flags, registers, memory and callstack) and
+ * rewinds to the first instruction. The program, ports and channels are kept.
+ */
+void pi_emulator_reset(struct pi_emulator_t *emulator);
+
 void pi_emulator_load_ports(
     struct pi_emulator_t *emulator,
     struct pi_port_t ports_in[PORTS_LEN]
 );
 
+/*
+ * Binds `port` to a shared memory channel (see ring.h), or unbinds it if
+ * `channel` is NULL. A blocking port waits while its ring is empty on PLD or
+ * full on PST, otherwise the load is skipped and the store dropped.
+ */
+void pi_emulator_bind_channel(
+    struct pi_emulator_t *emulator,
+    uint8_t port,
+    struct pi_channel_t *channel,
+    int blocking
+);
+
+/* Also verifies the program, see `pi_verify_program` */
 void pi_emulator_load_program(
     struct pi_emulator_t *emulator,
     const uint16_t program[MAX_PROGRAM_LEN]
 );
 
+void pi_verify_program(
+    const uint16_t program[MAX_PROGRAM_LEN],
+    struct pi_proof_t *proof
+);
+
 void pi_emulator_step(struct pi_emulator_t *emulator);
 void pi_emulator_execute(struct pi_emulator_t *emulator);
 
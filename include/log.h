@@ -1,45 +1,185 @@
 #ifndef __PANDAA73_LOG_H
 #define __PANDAA73_LOG_H
 
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-#if defined(PLG_LOGLEVEL_INFO)
-    #define PLG_INFO(...) do {\
-        fprintf(\
-            stderr,\
-            "INFO: %s@%d: %s\n",\
-            __FILE__, __LINE__,\
-            ##__VA_ARGS__\
+/*
+ * Levels are filtered twice: at compile time by the PLG_LOGLEVEL_* macros,
+ * which remove the call sites below the chosen level, and at runtime by
+ * `plg_set_level`, which costs a single load and compare per call site.
+ *
+ * Records are captured in binary form (call site plus arguments, monotonic
+ * time and thread id) into a lock-free per-thread buffer and formatted by a
+ * background writer, see `plg_start`, which merges the buffers by time. Until
+ * it is started, records are formatted synchronously.
+ *
+ * A buffer holds PLG_BUFFER_LEN records (256 unless defined at build time,
+ * like the levels). The writer is woken up early once one is half full, and
+ * records are dropped, and counted, while one is full.
+ *
+ * Formats must be string literals taking at most `PLG_MAX_ARGS` arguments,
+ * `*` widths and precisions are not supported. Strings are copied into the
+ * record (truncated to `PLG_STR_LEN` bytes in total), pointers are not.
+ */
+
+#define PLG_MAX_ARGS    8
+#define PLG_STR_LEN     96
+
+enum plg_level_t {
+    PLG_LEVEL_INFO,
+    PLG_LEVEL_WARN,
+    PLG_LEVEL_ERROR,
+    PLG_LEVEL_FATAL,
+};
+
+enum plg_arg_kind_t {
+    PLG_ARG_INT,
+    PLG_ARG_UINT,
+    PLG_ARG_DOUBLE,
+    PLG_ARG_PTR,
+    PLG_ARG_STR,
+};
+
+struct plg_site_t {
+    enum plg_level_t level;
+    const char *file;
+    int line;
+    const char *fmt;
+};
+
+struct plg_arg_t {
+    enum plg_arg_kind_t kind;
+
+    union {
+        long long i;
+        unsigned long long u;
+        double d;
+        const void *p;
+        const char *s;
+    };
+};
+
+extern _Atomic int plg_level;
+
+void plg_set_level(enum plg_level_t level);
+enum plg_level_t plg_get_level(void);
+
+/* Starts the background writer, or stops it after draining every buffer */
+void plg_start(void);
+void plg_stop(void);
+
+/* Fatal records are written synchronously, after draining the buffers */
+void plg_submit(
+    const struct plg_site_t *site,
+    const struct plg_arg_t *args,
+    uint8_t args_len
+);
+
+static inline int plg_enabled(enum plg_level_t level) {
+    return (int)level >= atomic_load_explicit(&plg_level, memory_order_relaxed);
+}
+
+static inline struct plg_arg_t plg_arg_int(long long x) {
+    return (struct plg_arg_t){ .kind = PLG_ARG_INT, .i = x };
+}
+
+static inline struct plg_arg_t plg_arg_uint(unsigned long long x) {
+    return (struct plg_arg_t){ .kind = PLG_ARG_UINT, .u = x };
+}
+
+static inline struct plg_arg_t plg_arg_double(double x) {
+    return (struct plg_arg_t){ .kind = PLG_ARG_DOUBLE, .d = x };
+}
+
+static inline struct plg_arg_t plg_arg_ptr(const void *x) {
+    return (struct plg_arg_t){ .kind = PLG_ARG_PTR, .p = x };
+}
+
+static inline struct plg_arg_t plg_arg_str(const char *x) {
+    return (struct plg_arg_t){ .kind = PLG_ARG_STR, .s = x };
+}
+
+#define PLG_ARG(x) _Generic((x),\
+    _Bool: plg_arg_int, char: plg_arg_int, signed char: plg_arg_int,\
+    short: plg_arg_int, int: plg_arg_int, long: plg_arg_int,\
+    long long: plg_arg_int,\
+    unsigned char: plg_arg_uint, unsigned short: plg_arg_uint,\
+    unsigned int: plg_arg_uint, unsigned long: plg_arg_uint,\
+    unsigned long long: plg_arg_uint,\
+    float: plg_arg_double, double: plg_arg_double,\
+    char *: plg_arg_str, const char *: plg_arg_str,\
+    default: plg_arg_ptr\
+)(x)
+
+#define PLG_ARGS_1(x)      PLG_ARG(x)
+#define PLG_ARGS_2(x, ...) PLG_ARG(x), PLG_ARGS_1(__VA_ARGS__)
+#define PLG_ARGS_3(x, ...) PLG_ARG(x), PLG_ARGS_2(__VA_ARGS__)
+#define PLG_ARGS_4(x, ...) PLG_ARG(x), PLG_ARGS_3(__VA_ARGS__)
+#define PLG_ARGS_5(x, ...) PLG_ARG(x), PLG_ARGS_4(__VA_ARGS__)
+#define PLG_ARGS_6(x, ...) PLG_ARG(x), PLG_ARGS_5(__VA_ARGS__)
+#define PLG_ARGS_7(x, ...) PLG_ARG(x), PLG_ARGS_6(__VA_ARGS__)
+#define PLG_ARGS_8(x, ...) PLG_ARG(x), PLG_ARGS_7(__VA_ARGS__)
+
+/*
+ * Argument lists for a format followed by N - 1 arguments. The format is
+ * replaced by a dummy argument, which also keeps the array non-empty.
+ */
+#define PLG_LIST_1(fmt)      { 0 }
+#define PLG_LIST_2(fmt, ...) { 0 }, PLG_ARGS_1(__VA_ARGS__)
+#define PLG_LIST_3(fmt, ...) { 0 }, PLG_ARGS_2(__VA_ARGS__)
+#define PLG_LIST_4(fmt, ...) { 0 }, PLG_ARGS_3(__VA_ARGS__)
+#define PLG_LIST_5(fmt, ...) { 0 }, PLG_ARGS_4(__VA_ARGS__)
+#define PLG_LIST_6(fmt, ...) { 0 }, PLG_ARGS_5(__VA_ARGS__)
+#define PLG_LIST_7(fmt, ...) { 0 }, PLG_ARGS_6(__VA_ARGS__)
+#define PLG_LIST_8(fmt, ...) { 0 }, PLG_ARGS_7(__VA_ARGS__)
+#define PLG_LIST_9(fmt, ...) { 0 }, PLG_ARGS_8(__VA_ARGS__)
+
+#define PLG_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, N, ...) N
+#define PLG_NARGS(...) PLG_NARGS_(__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define PLG_FIRST_(first, ...) first
+#define PLG_FIRST(...) PLG_FIRST_(__VA_ARGS__, 0)
+
+#define PLG_CAT_(a, b) a##b
+#define PLG_CAT(a, b) PLG_CAT_(a, b)
+
+/* Takes the format followed by its arguments */
+#define PLG_LOG(lvl, ...) do {\
+    if(plg_enabled(lvl)) {\
+        static const struct plg_site_t plg_site = {\
+            .level = lvl,\
+            .file = __FILE__,\
+            .line = __LINE__,\
+            .fmt = PLG_FIRST(__VA_ARGS__)\
+        };\
+        const struct plg_arg_t plg_args[] = {\
+            PLG_CAT(PLG_LIST_, PLG_NARGS(__VA_ARGS__))(__VA_ARGS__)\
+        };\
+        plg_submit(\
+            &plg_site, plg_args + 1,\
+            sizeof(plg_args) / sizeof(plg_args[0]) - 1\
         );\
-    } while(0)
+    }\
+} while(0)
+
+#if defined(PLG_LOGLEVEL_INFO)
+    #define PLG_INFO(...) PLG_LOG(PLG_LEVEL_INFO, __VA_ARGS__)
 #else
     #define PLG_INFO(...) do {} while(0)
 #endif
 
 #if defined(PLG_LOGLEVEL_INFO) || defined(PLG_LOGLEVEL_WARN)
-    #define PLG_WARN(...) do {\
-        fprintf(\
-            stderr,\
-            "WARN: %s@%d: %s\n",\
-            __FILE__, __LINE__,\
-            ##__VA_ARGS__\
-        );\
-    } while(0)
+    #define PLG_WARN(...) PLG_LOG(PLG_LEVEL_WARN, __VA_ARGS__)
 #else
     #define PLG_WARN(...) do {} while(0)
 #endif
 
 #if defined(PLG_LOGLEVEL_INFO) || defined(PLG_LOGLEVEL_WARN)\
         || defined(PLG_LOGLEVEL_ERROR)
-    #define PLG_ERROR(...) do {\
-        fprintf(\
-            stderr,\
-            "ERROR: %s@%d: %s\n",\
-            __FILE__, __LINE__,\
-            ##__VA_ARGS__\
-        );\
-    } while(0)
+    #define PLG_ERROR(...) PLG_LOG(PLG_LEVEL_ERROR, __VA_ARGS__)
 #else
     #define PLG_ERROR(...) do {} while(0)
 #endif
@@ -47,12 +187,7 @@
 #if defined(PLG_LOGLEVEL_INFO) || defined(PLG_LOGLEVEL_WARN)\
         || defined(PLG_LOGLEVEL_ERROR) || defined(PLG_LOGLEVEL_FATAL)
     #define PLG_FATAL(...) do {\
-        fprintf(\
-            stderr,\
-            "FATAL: %s@%d: %s\n",\
-            __FILE__, __LINE__,\
-            ##__VA_ARGS__\
-        );\
+        PLG_LOG(PLG_LEVEL_FATAL, __VA_ARGS__);\
         exit(EXIT_FAILURE);\
     } while(0)
 #else
@@ -0,0 +1,73 @@
+#ifndef __PANDAA73_PI_METRICS_H
+#define __PANDAA73_PI_METRICS_H
+
+#include "emulator.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Number of instructions retired between two updates of `retired` */
+#define PI_METRICS_BATCH 4096
+
+struct pi_metrics_snapshot_t {
+    uint64_t instances;
+
+    uint64_t retired;
+    uint64_t halts;
+    uint64_t random_bytes;
+
+    uint64_t port_reads[PORTS_LEN];
+    uint64_t port_writes[PORTS_LEN];
+    uint64_t port_callback_ns[PORTS_LEN];
+};
+
+/*
+ * Counters are only ever written by the thread running the emulator, so they
+ * need no read-modify-write, only tear-free loads and stores
+ */
+static inline void pi_metrics_add(_Atomic uint64_t *counter, uint64_t n) {
+    atomic_store_explicit(
+        counter,
+        atomic_load_explicit(counter, memory_order_relaxed) + n,
+        memory_order_relaxed
+    );
+}
+
+/*
+ * Adds the emulator to the aggregated metrics, or removes it, in which case
+ * its counters are folded into the totals and cleared. Both do nothing if the
+ * emulator already is (or isn't) attached, and neither may be called while
+ * it is running.
+ *
+ * The registry keeps a pointer into the emulator, which must be detached
+ * before its storage is freed or reused. `pi_emulator_init`, `pi_pool_release`
+ * and `pi_pool_destroy` detach the instances they are given.
+ */
+void pi_metrics_attach(struct pi_emulator_t *emulator);
+void pi_metrics_detach(struct pi_emulator_t *emulator);
+
+/*
+ * Returns non-zero if the emulator is attached. Only compares addresses while
+ * walking the registry, so `emulator` may point to uninitialized storage.
+ */
+int pi_metrics_is_attached(const struct pi_emulator_t *emulator);
+
+/* Sums the counters of every attached and previously detached emulator */
+void pi_metrics_snapshot(struct pi_metrics_snapshot_t *snapshot);
+
+/* Writes `snapshot` in the Prometheus text exposition format */
+void pi_metrics_write(
+    FILE *file,
+    const struct pi_metrics_snapshot_t *snapshot
+);
+
+/*
+ * Starts a background thread dumping a snapshot to `path` every `interval_ms`
+ * milliseconds. The file is replaced atomically, so that it can be scraped
+ * at any time (e.g. by node_exporter's textfile collector).
+ */
+void pi_metrics_export_start(const char *path, uint32_t interval_ms);
+void pi_metrics_export_stop(void);
+
+#endif /* __PANDAA73_PI_METRICS_H */
@@ -0,0 +1,52 @@
+#ifndef __PANDAA73_PI_POOL_H
+#define __PANDAA73_PI_POOL_H
+
+#include "emulator.h"
+
+#include <stddef.h>
+
+/* Minimum number of instances carved out of each slab */
+#define PI_POOL_SLAB_LEN    64
+#define PI_HUGEPAGE_SIZE    (2 * 1024 * 1024)
+
+struct pi_pool_slab_t {
+    void *base;
+    size_t size;
+};
+
+/*
+ * Hands out cache-line-aligned emulators from mmap-ed slabs. Every instance
+ * shares the pool's `/dev/urandom` descriptor. Pools are not thread-safe.
+ */
+struct pi_pool_t {
+    int urandom_fd;
+    int hugepages;
+
+    size_t slabs_len;
+    size_t slabs_cap;
+    struct pi_pool_slab_t *slabs;
+
+    /* Every instance carved so far, free or not */
+    size_t instances;
+
+    /* Always has room for every instance, see `pi_pool_release` */
+    size_t free_len;
+    size_t free_cap;
+    struct pi_emulator_t **free;
+};
+
+/* With `hugepages` set, slabs are 2 MiB and backed by transparent hugepages */
+void pi_pool_init(struct pi_pool_t *pool, int hugepages);
+void pi_pool_destroy(struct pi_pool_t *pool);
+
+/* Grows the pool until at least `count` instances are free */
+void pi_pool_reserve(struct pi_pool_t *pool, size_t count);
+
+/*
+ * Returns an initialized emulator with no ports or channels bound. The
+ * program of a recycled instance is stale and must be loaded again.
+ */
+struct pi_emulator_t *pi_pool_acquire(struct pi_pool_t *pool);
+void pi_pool_release(struct pi_pool_t *pool, struct pi_emulator_t *emulator);
+
+#endif /* __PANDAA73_PI_POOL_H */
@@ -0,0 +1,155 @@
+#ifndef __PANDAA73_PI_RING_H
+#define __PANDAA73_PI_RING_H
+
+#include "cache.h"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* Must be a power of two */
+#define PI_RING_LEN     4096
+
+/*
+ * Single-producer/single-consumer byte ring living in shared memory. `head`
+ * and `tail` are free-running counters, each written by one side only and
+ * kept on separate cache lines. Each side also keeps the last index it read
+ * from the other one next to its own, and only re-reads the real one when
+ * the ring looks full (producer) or empty (consumer). `waiters` counts the
+ * sides sleeping on a futex and is only written on the blocking path.
+ */
+struct pi_ring_t {
+    alignas(PI_CACHE_LINE) _Atomic uint32_t head;
+    uint32_t cached_tail;
+
+    alignas(PI_CACHE_LINE) _Atomic uint32_t tail;
+    uint32_t cached_head;
+
+    alignas(PI_CACHE_LINE) _Atomic uint32_t waiters;
+
+    alignas(PI_CACHE_LINE) uint8_t data[PI_RING_LEN];
+};
+
+/*
+ * Layout of the shared memory object bound to a port. The emulator pops
+ * `in` on PLD and pushes `out` on PST; the other process does the opposite.
+ */
+struct pi_channel_t {
+    struct pi_ring_t in;
+    struct pi_ring_t out;
+};
+
+/*
+ * Non-zero once this process is registered for expedited membarrier(2), see
+ * `pi_channel_map`. Sleeping sides then issue the barrier on behalf of both,
+ * and `pi_ring_notify` can do without one.
+ */
+extern _Atomic int pi_ring_asymmetric;
+
+/* Slow paths of `pi_ring_push`/`pi_ring_pop`, see ring.c */
+void pi_ring_wait_push(struct pi_ring_t *ring, uint8_t value);
+uint8_t pi_ring_wait_pop(struct pi_ring_t *ring);
+void pi_ring_wake(_Atomic uint32_t *word);
+
+/*
+ * Wakes the other side if it sleeps on `word`. The update of `word` must be
+ * ordered before the load of `waiters`, pairing with the waiting side so
+ * that a wakeup can't be missed. Without membarrier(2) this takes a full
+ * fence per byte, with it the compiler only must not reorder the two.
+ */
+static inline void pi_ring_notify(
+    struct pi_ring_t *ring,
+    _Atomic uint32_t *word
+) {
+    if(atomic_load_explicit(&pi_ring_asymmetric, memory_order_relaxed)) {
+        atomic_signal_fence(memory_order_seq_cst);
+    } else {
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+
+    if(atomic_load_explicit(&ring->waiters, memory_order_relaxed) != 0) {
+        pi_ring_wake(word);
+    }
+}
+
+static inline int pi_ring_try_push(struct pi_ring_t *ring, uint8_t value) {
+    const uint32_t head =
+        atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if(head - ring->cached_tail == PI_RING_LEN) {
+        ring->cached_tail =
+            atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        if(head - ring->cached_tail == PI_RING_LEN) { return 0; }
+    }
+
+    ring->data[head & (PI_RING_LEN - 1)] = value;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    pi_ring_notify(ring, &ring->head);
+
+    return 1;
+}
+
+static inline int pi_ring_try_pop(struct pi_ring_t *ring, uint8_t *value) {
+    const uint32_t tail =
+        atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if(ring->cached_head == tail) {
+        ring->cached_head =
+            atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        if(ring->cached_head == tail) { return 0; }
+    }
+
+    *value = ring->data[tail & (PI_RING_LEN - 1)];
+
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    pi_ring_notify(ring, &ring->tail);
+
+    return 1;
+}
+
+/* Blocks on a futex while the ring is full */
+static inline void pi_ring_push(struct pi_ring_t *ring, uint8_t value) {
+    if(!pi_ring_try_push(ring, value)) { pi_ring_wait_push(ring, value); }
+}
+
+/* Blocks on a futex while the ring is empty */
+static inline uint8_t pi_ring_pop(struct pi_ring_t *ring) {
+    uint8_t value;
+
+    if(!pi_ring_try_pop(ring, &value)) { value = pi_ring_wait_pop(ring); }
+
+    return value;
+}
+
+/*
+ * Channels are set up without logging nor exiting: on failure these return
+ * NULL or -1 and set `errno`.
+ */
+
+/*
+ * Maps a channel from `fd` (e.g. from `memfd_create`), growing the file if it
+ * is too small to hold one. The descriptor may be closed afterwards. Also
+ * registers the process for membarrier(2) when the kernel supports it.
+ */
+struct pi_channel_t *pi_channel_map(int fd);
+
+/* Creates and maps the POSIX shared memory object `name` */
+struct pi_channel_t *pi_channel_create(const char *name);
+
+/* Maps the existing POSIX shared memory object `name` */
+struct pi_channel_t *pi_channel_open(const char *name);
+
+int pi_channel_unmap(struct pi_channel_t *channel);
+
+/*
+ * Removes the shared memory object `name`. Processes that mapped it keep
+ * their mapping until they unmap it.
+ */
+int pi_channel_destroy(const char *name);
+
+#endif /* __PANDAA73_PI_RING_H */
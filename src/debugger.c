@@ -0,0 +1,237 @@
+#include "../include/debugger.h"
+
+#include "../include/log.h"
+
+#include <string.h>
+
+#define PIWCH_MASK (PIWCH_READ | PIWCH_WRITE)
+
+/* Values of `reported`, in the order the points are checked */
+#define REPORTED_NONE       0
+#define REPORTED_BREAKPOINT 1
+#define REPORTED_ALL        2
+
+static inline void set_watch(
+    struct pi_debugger_t *debugger,
+    uint8_t *watch,
+    uint8_t mode
+) {
+    if(*watch == 0 && mode != 0) { ++debugger->armed; }
+    if(*watch != 0 && mode == 0) { --debugger->armed; }
+
+    *watch = mode;
+}
+
+static inline int report(
+    struct pi_debugger_t *debugger,
+    enum pi_debug_event_kind_t kind,
+    uint8_t address
+) {
+    if(debugger->callback == NULL) { return 0; }
+
+    const struct pi_debug_event_t event = {
+        .kind     = kind,
+        .inst_ptr = debugger->emulator->inst_ptr,
+        .address  = address,
+    };
+
+    return debugger->callback(debugger, &event, debugger->userdata)
+        == PIDBG_STOP;
+}
+
+/*
+ * Reports the points hit by the instruction at `inst_ptr` that come after
+ * `reported`, before it is executed. Returns how far it got if the callback
+ * asked to stop, `REPORTED_NONE` otherwise.
+ */
+static uint8_t check_points(struct pi_debugger_t *debugger, uint8_t reported) {
+    const struct pi_emulator_t *emulator = debugger->emulator;
+
+    const uint16_t instruction = emulator->program[emulator->inst_ptr];
+
+    if(reported == REPORTED_ALL) { return REPORTED_NONE; }
+
+    if(reported < REPORTED_BREAKPOINT
+            && debugger->traps[emulator->inst_ptr] != 0) {
+        if(report(debugger, PIDBG_BREAKPOINT, 0)) {
+            return REPORTED_BREAKPOINT;
+        }
+    }
+
+    /* An instruction hits at most one watchpoint */
+    int stop = 0;
+
+    const uint16_t B    = (instruction >> 0) & 0x07;
+    const uint8_t  port = (instruction >> 0) & 0x07;
+
+    switch((enum pi_opcode_t)(instruction >> 11)) {
+        case PIOP_MST:
+            if((debugger->mem_watch[emulator->regs[B]] & PIWCH_WRITE) != 0) {
+                stop = report(debugger, PIDBG_MEM_WRITE, emulator->regs[B]);
+            }
+            break;
+        case PIOP_MLD:
+            if((debugger->mem_watch[emulator->regs[B]] & PIWCH_READ) != 0) {
+                stop = report(debugger, PIDBG_MEM_READ, emulator->regs[B]);
+            }
+            break;
+        case PIOP_PST:
+            if((debugger->port_watch[port] & PIWCH_WRITE) != 0) {
+                stop = report(debugger, PIDBG_PORT_WRITE, port);
+            }
+            break;
+        case PIOP_PLD:
+            /* Random loads don't touch the port */
+            if(((instruction >> 3) & 0x01) != 0) { break; }
+
+            if((debugger->port_watch[port] & PIWCH_READ) != 0) {
+                stop = report(debugger, PIDBG_PORT_READ, port);
+            }
+            break;
+        default:
+            break;
+    }
+
+    return stop ? REPORTED_ALL : REPORTED_NONE;
+}
+
+/* ========================================================================== */
+/* =========================== Debugger Functions =========================== */
+/* ========================================================================== */
+
+void pi_debugger_init(
+    struct pi_debugger_t *debugger,
+    struct pi_emulator_t *emulator
+) {
+    if(!debugger) { PLG_FATAL("debugger_init: debugger is NULL"); }
+    if(!emulator) { PLG_FATAL("debugger_init: emulator is NULL"); }
+
+    memset(debugger, 0x00, sizeof(*debugger));
+
+    debugger->emulator = emulator;
+}
+
+void pi_debugger_set_callback(
+    struct pi_debugger_t *debugger,
+    pi_debug_callback_t callback,
+    void *userdata
+) {
+    if(!debugger) { PLG_FATAL("set_callback: debugger is NULL"); }
+
+    debugger->callback = callback;
+    debugger->userdata = userdata;
+}
+
+void pi_debugger_add_breakpoint(
+    struct pi_debugger_t *debugger,
+    uint16_t inst_ptr
+) {
+    if(!debugger) { PLG_FATAL("add_breakpoint: debugger is NULL"); }
+    if(inst_ptr >= MAX_PROGRAM_LEN) {
+        PLG_FATAL("add_breakpoint: inst_ptr is out of range");
+    }
+
+    set_watch(debugger, &debugger->traps[inst_ptr], 1);
+}
+
+void pi_debugger_remove_breakpoint(
+    struct pi_debugger_t *debugger,
+    uint16_t inst_ptr
+) {
+    if(!debugger) { PLG_FATAL("remove_breakpoint: debugger is NULL"); }
+    if(inst_ptr >= MAX_PROGRAM_LEN) {
+        PLG_FATAL("remove_breakpoint: inst_ptr is out of range");
+    }
+
+    set_watch(debugger, &debugger->traps[inst_ptr], 0);
+}
+
+void pi_debugger_add_mem_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t address,
+    uint8_t mode
+) {
+    if(!debugger) { PLG_FATAL("add_mem_watchpoint: debugger is NULL"); }
+    if((mode & ~PIWCH_MASK) != 0) {
+        PLG_FATAL("add_mem_watchpoint: invalid mode");
+    }
+
+    set_watch(
+        debugger,
+        &debugger->mem_watch[address],
+        debugger->mem_watch[address] | mode
+    );
+}
+
+void pi_debugger_remove_mem_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t address
+) {
+    if(!debugger) { PLG_FATAL("remove_mem_watchpoint: debugger is NULL"); }
+
+    set_watch(debugger, &debugger->mem_watch[address], 0);
+}
+
+void pi_debugger_add_port_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t port,
+    uint8_t mode
+) {
+    if(!debugger) { PLG_FATAL("add_port_watchpoint: debugger is NULL"); }
+    if(port >= PORTS_LEN) {
+        PLG_FATAL("add_port_watchpoint: port is out of range");
+    }
+    if((mode & ~PIWCH_MASK) != 0) {
+        PLG_FATAL("add_port_watchpoint: invalid mode");
+    }
+
+    set_watch(
+        debugger,
+        &debugger->port_watch[port],
+        debugger->port_watch[port] | mode
+    );
+}
+
+void pi_debugger_remove_port_watchpoint(
+    struct pi_debugger_t *debugger,
+    uint8_t port
+) {
+    if(!debugger) { PLG_FATAL("remove_port_watchpoint: debugger is NULL"); }
+    if(port >= PORTS_LEN) {
+        PLG_FATAL("remove_port_watchpoint: port is out of range");
+    }
+
+    set_watch(debugger, &debugger->port_watch[port], 0);
+}
+
+int pi_debugger_execute(struct pi_debugger_t *debugger) {
+    if(!debugger) { PLG_FATAL("debugger_execute: debugger is NULL"); }
+
+    struct pi_emulator_t *emulator = debugger->emulator;
+
+    /*
+     * Points may be removed from the callback, in which case the rest of the
+     * program runs on the regular execution loop
+     */
+    while(debugger->armed != 0 && (emulator->flags & PIFLG_HLT) == 0) {
+        const uint8_t reported = debugger->stopped_at == emulator->inst_ptr
+            ? debugger->reported
+            : REPORTED_NONE;
+
+        debugger->reported = check_points(debugger, reported);
+
+        if(debugger->reported != REPORTED_NONE) {
+            debugger->stopped_at = emulator->inst_ptr;
+
+            return 1;
+        }
+
+        pi_emulator_step(emulator);
+    }
+
+    debugger->reported = REPORTED_NONE;
+
+    pi_emulator_execute(emulator);
+
+    return 0;
+}
@@ -1,11 +1,14 @@
 #include "../include/emulator.h"
 
 #include "../include/log.h"
+#include "../include/metrics.h"
+#include "../include/ring.h"
 
 #include <string.h>
 #include <limits.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <time.h>
 
 static inline uint8_t __rsh(uint8_t x, uint8_t n) {
     uint8_t mask = (CHAR_BIT * sizeof(x) - 1);
@@ -46,9 +49,18 @@ static inline uint8_t gen_random_byte(struct pi_emulator_t *emulator) {
         PLG_FATAL("Failed to read from `/dev/urandom`");
     }
 
+    pi_metrics_add(&emulator->metrics.random_bytes, 1);
+
     return x;
 }
 
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
 /* ========================================================================== */
 /* ============================ Branch Conditions =========================== */
 /* ========================================================================== */
@@ -70,44 +82,69 @@ int (*check[PICND_SIZE])(struct pi_emulator_t *) = {
 /* ============================== Instructions ============================== */
 /* ========================================================================== */
 
-static inline void  nop(struct pi_emulator_t *emulator);
-static inline void  hlt(struct pi_emulator_t *emulator);
-static inline void  jmp(struct pi_emulator_t *emulator);
-static inline void  brh(struct pi_emulator_t *emulator);
-static inline void call(struct pi_emulator_t *emulator);
-static inline void  ret(struct pi_emulator_t *emulator);
-static inline void  ldi(struct pi_emulator_t *emulator);
-static inline void  mov(struct pi_emulator_t *emulator);
-static inline void  add(struct pi_emulator_t *emulator);
-static inline void  sub(struct pi_emulator_t *emulator);
-static inline void addi(struct pi_emulator_t *emulator);
-static inline void adsi(struct pi_emulator_t *emulator);
-static inline void  xor(struct pi_emulator_t *emulator);
-static inline void  and(struct pi_emulator_t *emulator);
-static inline void   or(struct pi_emulator_t *emulator);
-static inline void  cmp(struct pi_emulator_t *emulator);
-static inline void xori(struct pi_emulator_t *emulator);
-static inline void andi(struct pi_emulator_t *emulator);
-static inline void  ori(struct pi_emulator_t *emulator);
-static inline void cmpi(struct pi_emulator_t *emulator);
-static inline void  rsh(struct pi_emulator_t *emulator);
-static inline void  lsh(struct pi_emulator_t *emulator);
-static inline void  rtl(struct pi_emulator_t *emulator);
-static inline void  ars(struct pi_emulator_t *emulator);
-static inline void rshi(struct pi_emulator_t *emulator);
-static inline void lshi(struct pi_emulator_t *emulator);
-static inline void rtli(struct pi_emulator_t *emulator);
-static inline void arsi(struct pi_emulator_t *emulator);
-static inline void  mst(struct pi_emulator_t *emulator);
-static inline void  mld(struct pi_emulator_t *emulator);
-static inline void  pst(struct pi_emulator_t *emulator);
-static inline void  pld(struct pi_emulator_t *emulator);
+static inline void  nop(struct pi_emulator_t *emulator, const int verified);
+static inline void  hlt(struct pi_emulator_t *emulator, const int verified);
+static inline void  jmp(struct pi_emulator_t *emulator, const int verified);
+static inline void  brh(struct pi_emulator_t *emulator, const int verified);
+static inline void call(struct pi_emulator_t *emulator, const int verified);
+static inline void  ret(struct pi_emulator_t *emulator, const int verified);
+static inline void  ldi(struct pi_emulator_t *emulator, const int verified);
+static inline void  mov(struct pi_emulator_t *emulator, const int verified);
+static inline void  add(struct pi_emulator_t *emulator, const int verified);
+static inline void  sub(struct pi_emulator_t *emulator, const int verified);
+static inline void addi(struct pi_emulator_t *emulator, const int verified);
+static inline void adsi(struct pi_emulator_t *emulator, const int verified);
+static inline void  xor(struct pi_emulator_t *emulator, const int verified);
+static inline void  and(struct pi_emulator_t *emulator, const int verified);
+static inline void   or(struct pi_emulator_t *emulator, const int verified);
+static inline void  cmp(struct pi_emulator_t *emulator, const int verified);
+static inline void xori(struct pi_emulator_t *emulator, const int verified);
+static inline void andi(struct pi_emulator_t *emulator, const int verified);
+static inline void  ori(struct pi_emulator_t *emulator, const int verified);
+static inline void cmpi(struct pi_emulator_t *emulator, const int verified);
+static inline void  rsh(struct pi_emulator_t *emulator, const int verified);
+static inline void  lsh(struct pi_emulator_t *emulator, const int verified);
+static inline void  rtl(struct pi_emulator_t *emulator, const int verified);
+static inline void  ars(struct pi_emulator_t *emulator, const int verified);
+static inline void rshi(struct pi_emulator_t *emulator, const int verified);
+static inline void lshi(struct pi_emulator_t *emulator, const int verified);
+static inline void rtli(struct pi_emulator_t *emulator, const int verified);
+static inline void arsi(struct pi_emulator_t *emulator, const int verified);
+static inline void  mst(struct pi_emulator_t *emulator, const int verified);
+static inline void  mld(struct pi_emulator_t *emulator, const int verified);
+static inline void  pst(struct pi_emulator_t *emulator, const int verified);
+static inline void  pld(struct pi_emulator_t *emulator, const int verified);
+
+/*
+ * The dispatch table holds the safe variant of every instruction. Verified
+ * programs don't go through it, see `verified_pi_emulator_run`.
+ */
+#define INSTRUCTION_VARIANTS(name)\
+    static void name##_safe(struct pi_emulator_t *emulator) {\
+        name(emulator, 0);\
+    }
+
+INSTRUCTION_VARIANTS(nop)  INSTRUCTION_VARIANTS(hlt)  INSTRUCTION_VARIANTS(jmp)
+INSTRUCTION_VARIANTS(brh)  INSTRUCTION_VARIANTS(call) INSTRUCTION_VARIANTS(ret)
+INSTRUCTION_VARIANTS(ldi)  INSTRUCTION_VARIANTS(mov)  INSTRUCTION_VARIANTS(add)
+INSTRUCTION_VARIANTS(sub)  INSTRUCTION_VARIANTS(addi) INSTRUCTION_VARIANTS(adsi)
+INSTRUCTION_VARIANTS(xor)  INSTRUCTION_VARIANTS(and)  INSTRUCTION_VARIANTS(or)
+INSTRUCTION_VARIANTS(cmp)  INSTRUCTION_VARIANTS(xori) INSTRUCTION_VARIANTS(andi)
+INSTRUCTION_VARIANTS(ori)  INSTRUCTION_VARIANTS(cmpi) INSTRUCTION_VARIANTS(rsh)
+INSTRUCTION_VARIANTS(lsh)  INSTRUCTION_VARIANTS(rtl)  INSTRUCTION_VARIANTS(ars)
+INSTRUCTION_VARIANTS(rshi) INSTRUCTION_VARIANTS(lshi) INSTRUCTION_VARIANTS(rtli)
+INSTRUCTION_VARIANTS(arsi) INSTRUCTION_VARIANTS(mst)  INSTRUCTION_VARIANTS(mld)
+INSTRUCTION_VARIANTS(pst)  INSTRUCTION_VARIANTS(pld)
 
 void (*execute[PIOP_SIZE])(struct pi_emulator_t *) = {
-     nop,  hlt,  jmp,  brh, call,  ret,  ldi,  mov,
-     add,  sub, addi, adsi,  xor,  and,   or,  cmp,
-    xori, andi,  ori, cmpi,  rsh,  lsh,  rtl,  ars,
-    rshi, lshi, rtli, arsi,  mst,  mld,  pst,  pld,
+     nop_safe,  hlt_safe,  jmp_safe,  brh_safe,
+    call_safe,  ret_safe,  ldi_safe,  mov_safe,
+     add_safe,  sub_safe, addi_safe, adsi_safe,
+     xor_safe,  and_safe,   or_safe,  cmp_safe,
+    xori_safe, andi_safe,  ori_safe, cmpi_safe,
+     rsh_safe,  lsh_safe,  rtl_safe,  ars_safe,
+    rshi_safe, lshi_safe, rtli_safe, arsi_safe,
+     mst_safe,  mld_safe,  pst_safe,  pld_safe,
 };
 
 /* ========================================================================== */
@@ -117,6 +154,9 @@ void (*execute[PIOP_SIZE])(struct pi_emulator_t *) = {
 void pi_emulator_init(struct pi_emulator_t *emulator) {
     if(!emulator) { PLG_FATAL("init: emulator is NULL"); }
 
+    /* The storage may be garbage, so the registry is asked rather than it */
+    if(pi_metrics_is_attached(emulator)) { pi_metrics_detach(emulator); }
+
     memset(emulator, 0x00, sizeof(*emulator));
 
     emulator->urandom_fd = open("/dev/urandom", O_RDONLY);
@@ -125,6 +165,18 @@ void pi_emulator_init(struct pi_emulator_t *emulator) {
     }
 }
 
+void pi_emulator_reset(struct pi_emulator_t *emulator) {
+    if(!emulator) { PLG_FATAL("reset: emulator is NULL"); }
+
+    emulator->flags = 0;
+    emulator->inst_ptr = 0;
+    emulator->callstack_ptr = 0;
+
+    memset(emulator->regs, 0x00, sizeof(emulator->regs));
+    memset(emulator->callstack, 0x00, sizeof(emulator->callstack));
+    memset(emulator->mem, 0x00, sizeof(emulator->mem));
+}
+
 void pi_emulator_load_ports(
     struct pi_emulator_t *emulator,
     struct pi_port_t ports[PORTS_LEN]
@@ -137,6 +189,24 @@ void pi_emulator_load_ports(
     }
 }
 
+void pi_emulator_bind_channel(
+    struct pi_emulator_t *emulator,
+    uint8_t port,
+    struct pi_channel_t *channel,
+    int blocking
+) {
+    if(!emulator)         { PLG_FATAL("bind_channel: emulator is NULL"); }
+    if(port >= PORTS_LEN) { PLG_FATAL("bind_channel: port is out of range"); }
+
+    emulator->channels[port] = channel;
+
+    if(channel != NULL && blocking) {
+        emulator->blocking_channels |= (1 << port);
+    } else {
+        emulator->blocking_channels &= ~(1 << port);
+    }
+}
+
 void pi_emulator_load_program(
     struct pi_emulator_t *emulator,
     const uint16_t program[MAX_PROGRAM_LEN]
@@ -147,6 +217,8 @@ void pi_emulator_load_program(
     for(uint16_t i = 0; i < MAX_PROGRAM_LEN; ++i) {
         emulator->program[i] = program[i];
     }
+
+    pi_verify_program(emulator->program, &emulator->proof);
 }
 
 static inline void unsafe_pi_emulator_step(struct pi_emulator_t *emulator) {
@@ -163,17 +235,107 @@ static inline void unsafe_pi_emulator_step(struct pi_emulator_t *emulator) {
     emulator->inst_ptr = (emulator->inst_ptr + 1) % MAX_PROGRAM_LEN;
 }
 
+/*
+ * Runs a verified program for at most `budget` instructions or until it
+ * halts, returning the number of instructions retired. Range checks and r0
+ * guards are compiled out (see verifier.c), and the switch lets the compiler
+ * inline every handler instead of calling through a table.
+ */
+static uint32_t verified_pi_emulator_run(
+    struct pi_emulator_t *emulator,
+    uint32_t budget
+) {
+    for(uint32_t retired = 1; retired <= budget; ++retired) {
+        const uint16_t instruction = emulator->program[emulator->inst_ptr];
+
+        switch((enum pi_opcode_t)(instruction >> 11)) {
+            case PIOP_NOP:   nop(emulator, 1); break;
+            case PIOP_HLT:
+                hlt(emulator, 1);
+                ++emulator->inst_ptr;
+
+                return retired;
+            case PIOP_JMP:   jmp(emulator, 1); break;
+            case PIOP_BRH:   brh(emulator, 1); break;
+            case PIOP_CALL: call(emulator, 1); break;
+            case PIOP_RET:   ret(emulator, 1); break;
+            case PIOP_LDI:   ldi(emulator, 1); break;
+            case PIOP_MOV:   mov(emulator, 1); break;
+            case PIOP_ADD:   add(emulator, 1); break;
+            case PIOP_SUB:   sub(emulator, 1); break;
+            case PIOP_ADDI: addi(emulator, 1); break;
+            case PIOP_ADSI: adsi(emulator, 1); break;
+            case PIOP_XOR:   xor(emulator, 1); break;
+            case PIOP_AND:   and(emulator, 1); break;
+            case PIOP_OR:     or(emulator, 1); break;
+            case PIOP_CMP:   cmp(emulator, 1); break;
+            case PIOP_XORI: xori(emulator, 1); break;
+            case PIOP_ANDI: andi(emulator, 1); break;
+            case PIOP_ORI:   ori(emulator, 1); break;
+            case PIOP_CMPI: cmpi(emulator, 1); break;
+            case PIOP_RSH:   rsh(emulator, 1); break;
+            case PIOP_LSH:   lsh(emulator, 1); break;
+            case PIOP_RTL:   rtl(emulator, 1); break;
+            case PIOP_ARS:   ars(emulator, 1); break;
+            case PIOP_RSHI: rshi(emulator, 1); break;
+            case PIOP_LSHI: lshi(emulator, 1); break;
+            case PIOP_RTLI: rtli(emulator, 1); break;
+            case PIOP_ARSI: arsi(emulator, 1); break;
+            case PIOP_MST:   mst(emulator, 1); break;
+            case PIOP_MLD:   mld(emulator, 1); break;
+            case PIOP_PST:   pst(emulator, 1); break;
+            case PIOP_PLD:   pld(emulator, 1); break;
+            default: break;
+        }
+
+        /* The verifier made sure this can't run past the end of the program */
+        ++emulator->inst_ptr;
+    }
+
+    return budget;
+}
+
+/*
+ * The proof only covers executions starting outside of any call, from an
+ * instruction reachable from the start of the program
+ */
+static inline int is_verified(const struct pi_emulator_t *emulator) {
+    const uint16_t inst_ptr = emulator->inst_ptr;
+
+    return emulator->proof.verified
+        && emulator->callstack_ptr == 0
+        && (emulator->proof.toplevel[inst_ptr / 64]
+            & (UINT64_C(1) << (inst_ptr % 64))) != 0;
+}
+
 inline void pi_emulator_step(struct pi_emulator_t *emulator) {
     if(!emulator) { PLG_FATAL("step: emulator is NULL"); }
 
     unsafe_pi_emulator_step(emulator);
+
+    pi_metrics_add(&emulator->metrics.retired, 1);
 }
 
 void pi_emulator_execute(struct pi_emulator_t *emulator) {
     if(!emulator) { PLG_FATAL("execute: emulator is NULL"); }
 
+    const int verified = is_verified(emulator);
+
+    /* Instructions retired are counted locally and published in batches */
     while((emulator->flags & PIFLG_HLT) == 0) {
-        unsafe_pi_emulator_step(emulator);
+        uint32_t retired = 0;
+
+        if(verified) {
+            retired = verified_pi_emulator_run(emulator, PI_METRICS_BATCH);
+        } else {
+            while(retired < PI_METRICS_BATCH
+                    && (emulator->flags & PIFLG_HLT) == 0) {
+                unsafe_pi_emulator_step(emulator);
+                ++retired;
+            }
+        }
+
+        pi_metrics_add(&emulator->metrics.retired, retired);
     }
 }
 
@@ -218,96 +380,129 @@ static inline int sof(struct pi_emulator_t *emulator) {
 /* ============================== Instructions ============================== */
 /* ========================================================================== */
 
-static inline void  nop(struct pi_emulator_t *emulator) {
+static inline void  nop(struct pi_emulator_t *emulator, const int verified) {
     (void)emulator;
+    (void)verified;
 }
 
-static inline void  hlt(struct pi_emulator_t *emulator) {
+static inline void  hlt(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     emulator->flags |= PIFLG_HLT;
+
+    pi_metrics_add(&emulator->metrics.halts, 1);
 }
 
-static inline void  jmp(struct pi_emulator_t *emulator) {
+static inline void  jmp(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     emulator->inst_ptr = instruction & 0x07FF;
 }
 
-static inline void  brh(struct pi_emulator_t *emulator) {
+static inline void  brh(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const enum pi_branch_condition_t cond = (instruction >> 8) & 0x07;
     const uint8_t address = instruction & 0xFF;
 
-    if(!check[cond](emulator)) return;
+    /* Same as the table, but inlined into the verified loop */
+    if(verified) {
+        int taken = 0;
+
+        switch(cond) {
+            case PICND_BEQ: taken = beq(emulator); break;
+            case PICND_BNE: taken = bne(emulator); break;
+            case PICND_POS: taken = pos(emulator); break;
+            case PICND_NEG: taken = neg(emulator); break;
+            case PICND_PEQ: taken = peq(emulator); break;
+            case PICND_NEQ: taken = neq(emulator); break;
+            case PICND_EVN: taken = evn(emulator); break;
+            case PICND_SOF: taken = sof(emulator); break;
+            default: break;
+        }
+
+        if(!taken) return;
+    } else if(!check[cond](emulator)) {
+        return;
+    }
 
     emulator->inst_ptr = (emulator->inst_ptr & 0x700) | address;
 }
 
-static inline void call(struct pi_emulator_t *emulator) {
+static inline void call(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     emulator->callstack[emulator->callstack_ptr] = emulator->inst_ptr;
 
-    emulator->callstack_ptr = (emulator->callstack_ptr + 1) % CALLSTACK_LEN;
+    emulator->callstack_ptr = verified
+        ? emulator->callstack_ptr + 1
+        : (emulator->callstack_ptr + 1) % CALLSTACK_LEN;
 
     emulator->inst_ptr = instruction & 0x07FF;
 }
 
-static inline void  ret(struct pi_emulator_t *emulator) {
-    emulator->inst_ptr = emulator->callstack[emulator->callstack_ptr];
+static inline void  ret(struct pi_emulator_t *emulator, const int verified) {
+    emulator->callstack_ptr = verified
+        ? emulator->callstack_ptr - 1
+        : (emulator->callstack_ptr + CALLSTACK_LEN - 1) % CALLSTACK_LEN;
 
-    emulator->callstack_ptr =
-        (emulator->callstack_ptr + CALLSTACK_LEN - 1) % CALLSTACK_LEN;
+    emulator->inst_ptr = emulator->callstack[emulator->callstack_ptr];
 }
 
-static inline void  ldi(struct pi_emulator_t *emulator) {
+static inline void  ldi(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A   = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0xFF;
 
-    if(A != 0) { emulator->regs[A] = imm; }
+    if(verified || A != 0) { emulator->regs[A] = imm; }
 }
 
-static inline void  mov(struct pi_emulator_t *emulator) {
+static inline void  mov(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(A != 0) { emulator->regs[A] = emulator->regs[B]; }
+    if(verified || A != 0) { emulator->regs[A] = emulator->regs[B]; }
 }
 
-static inline void  add(struct pi_emulator_t *emulator) {
+static inline void  add(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) { emulator->regs[C] = emulator->regs[A] + emulator->regs[B]; }
+    if(verified || C != 0) {
+        emulator->regs[C] = emulator->regs[A] + emulator->regs[B];
+    }
 }
 
-static inline void  sub(struct pi_emulator_t *emulator) {
+static inline void  sub(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) { emulator->regs[C] = emulator->regs[A] - emulator->regs[B]; }
+    if(verified || C != 0) {
+        emulator->regs[C] = emulator->regs[A] - emulator->regs[B];
+    }
 }
 
-static inline void addi(struct pi_emulator_t *emulator) {
+static inline void addi(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A   = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0xFF;
 
-    if(A != 0) { emulator->regs[A] += imm; }
+    if(verified || A != 0) { emulator->regs[A] += imm; }
 }
 
-static inline void adsi(struct pi_emulator_t *emulator) {
+static inline void adsi(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
@@ -318,40 +513,48 @@ static inline void adsi(struct pi_emulator_t *emulator) {
     sximm |= (sximm & 0x10) << 2;
     sximm |= (sximm & 0x10) << 3;
 
-    if(A != 0) { emulator->regs[C] = emulator->regs[A] + sximm; }
+    if(verified || A != 0) { emulator->regs[C] = emulator->regs[A] + sximm; }
 }
 
-static inline void  xor(struct pi_emulator_t *emulator) {
+static inline void  xor(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) { emulator->regs[C] = emulator->regs[A] ^ emulator->regs[B]; }
+    if(verified || C != 0) {
+        emulator->regs[C] = emulator->regs[A] ^ emulator->regs[B];
+    }
 }
 
-static inline void  and(struct pi_emulator_t *emulator) {
+static inline void  and(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) { emulator->regs[C] = emulator->regs[A] & emulator->regs[B]; }
+    if(verified || C != 0) {
+        emulator->regs[C] = emulator->regs[A] & emulator->regs[B];
+    }
 }
 
-static inline void   or(struct pi_emulator_t *emulator) {
+static inline void   or(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) { emulator->regs[C] = emulator->regs[A] | emulator->regs[B]; }
+    if(verified || C != 0) {
+        emulator->regs[C] = emulator->regs[A] | emulator->regs[B];
+    }
 }
 
-static inline void  cmp(struct pi_emulator_t *emulator) {
+static inline void  cmp(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
@@ -366,34 +569,36 @@ static inline void  cmp(struct pi_emulator_t *emulator) {
     if((diff & 0x40) != 0) { emulator->flags |= PIFLG_BIT7; }
 }
 
-static inline void xori(struct pi_emulator_t *emulator) {
+static inline void xori(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A   = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0xFF;
 
-    if(A != 0) { emulator->regs[A] ^= imm; }
+    if(verified || A != 0) { emulator->regs[A] ^= imm; }
 }
 
-static inline void andi(struct pi_emulator_t *emulator) {
+static inline void andi(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A   = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0xFF;
 
-    if(A != 0) { emulator->regs[A] &= imm; }
+    if(verified || A != 0) { emulator->regs[A] &= imm; }
 }
 
-static inline void  ori(struct pi_emulator_t *emulator) {
+static inline void  ori(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A   = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0xFF;
 
-    if(A != 0) { emulator->regs[A] |= imm; }
+    if(verified || A != 0) { emulator->regs[A] |= imm; }
 }
 
-static inline void cmpi(struct pi_emulator_t *emulator) {
+static inline void cmpi(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A   = (instruction >> 8) & 0x07;
@@ -408,14 +613,14 @@ static inline void cmpi(struct pi_emulator_t *emulator) {
     if((diff & 0x01) != 0) { emulator->flags |= PIFLG_LSB; }
 }
 
-static inline void  rsh(struct pi_emulator_t *emulator) {
+static inline void  rsh(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) {
+    if(verified || C != 0) {
         emulator->regs[C] = __rsh(
             emulator->regs[A],
             -emulator->regs[B]
@@ -423,14 +628,14 @@ static inline void  rsh(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void  lsh(struct pi_emulator_t *emulator) {
+static inline void  lsh(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) {
+    if(verified || C != 0) {
         emulator->regs[C] = __lsh(
             emulator->regs[A],
             emulator->regs[B]
@@ -438,14 +643,14 @@ static inline void  lsh(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void  rtl(struct pi_emulator_t *emulator) {
+static inline void  rtl(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint16_t C = (instruction >> 5) & 0x07;
     const uint16_t B = (instruction >> 0) & 0x07;
 
-    if(C != 0) {
+    if(verified || C != 0) {
         emulator->regs[C] = __rotl(
             emulator->regs[A],
             emulator->regs[B]
@@ -453,7 +658,7 @@ static inline void  rtl(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void  ars(struct pi_emulator_t *emulator) {
+static inline void  ars(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
@@ -465,7 +670,7 @@ static inline void  ars(struct pi_emulator_t *emulator) {
      * in the ISA. I am not sure.
      */
 
-    if(C != 0) {
+    if(verified || C != 0) {
         emulator->regs[C] = __ars(
             emulator->regs[A],
             emulator->regs[B]
@@ -473,13 +678,13 @@ static inline void  ars(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void rshi(struct pi_emulator_t *emulator) {
+static inline void rshi(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0x07;
 
-    if(A != 0) {
+    if(verified || A != 0) {
         emulator->regs[A] = __rsh(
             emulator->regs[A],
             -imm
@@ -487,13 +692,13 @@ static inline void rshi(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void lshi(struct pi_emulator_t *emulator) {
+static inline void lshi(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0x07;
 
-    if(A != 0) {
+    if(verified || A != 0) {
         emulator->regs[A] = __lsh(
             emulator->regs[A],
             imm
@@ -501,13 +706,13 @@ static inline void lshi(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void rtli(struct pi_emulator_t *emulator) {
+static inline void rtli(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
     const uint8_t imm = (instruction >> 0) & 0x07;
 
-    if(A != 0) {
+    if(verified || A != 0) {
         emulator->regs[A] = __rotl(
             emulator->regs[A],
             imm
@@ -515,7 +720,7 @@ static inline void rtli(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void arsi(struct pi_emulator_t *emulator) {
+static inline void arsi(struct pi_emulator_t *emulator, const int verified) {
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
@@ -526,7 +731,7 @@ static inline void arsi(struct pi_emulator_t *emulator) {
      * in the ISA. I am not sure.
      */
 
-    if(A != 0) {
+    if(verified || A != 0) {
         emulator->regs[A] = __ars(
             emulator->regs[A],
             imm
@@ -534,7 +739,9 @@ static inline void arsi(struct pi_emulator_t *emulator) {
     }
 }
 
-static inline void  mst(struct pi_emulator_t *emulator) {
+static inline void  mst(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
@@ -543,7 +750,9 @@ static inline void  mst(struct pi_emulator_t *emulator) {
     emulator->mem[emulator->regs[B]] = emulator->regs[A];
 }
 
-static inline void  mld(struct pi_emulator_t *emulator) {
+static inline void  mld(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A = (instruction >> 8) & 0x07;
@@ -552,26 +761,66 @@ static inline void  mld(struct pi_emulator_t *emulator) {
     emulator->regs[A] = emulator->mem[emulator->regs[B]];
 }
 
-static inline void  pst(struct pi_emulator_t *emulator) {
+static inline void  pst(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A    = (instruction >> 8) & 0x07;
     const uint16_t port = (instruction >> 0) & 0x07;
 
-    if(emulator->ports[port].writer != NULL) {
+    struct pi_channel_t *channel = emulator->channels[port];
+
+    pi_metrics_add(&emulator->metrics.port_writes[port], 1);
+
+    if(channel != NULL) {
+        if((emulator->blocking_channels & (1 << port)) != 0) {
+            pi_ring_push(&channel->out, emulator->regs[A]);
+        } else {
+            pi_ring_try_push(&channel->out, emulator->regs[A]);
+        }
+    } else if(emulator->ports[port].writer != NULL) {
+        const uint64_t start = now_ns();
+
         emulator->ports[port].writer(emulator->regs[A]);
+
+        pi_metrics_add(
+            &emulator->metrics.port_callback_ns[port], now_ns() - start
+        );
     }
 }
 
-static inline void  pld(struct pi_emulator_t *emulator) {
+static inline void  pld(struct pi_emulator_t *emulator, const int verified) {
+    (void)verified;
+
     const uint16_t instruction = emulator->program[emulator->inst_ptr];
 
     const uint16_t A    = (instruction >> 8) & 0x07;
     const uint16_t port = (instruction >> 0) & 0x07;
 
+    struct pi_channel_t *channel = emulator->channels[port];
+
     if(((instruction >> 3) & 0x01) != 0) {
         emulator->regs[A] = gen_random_byte(emulator);
+
+        return;
+    }
+
+    pi_metrics_add(&emulator->metrics.port_reads[port], 1);
+
+    if(channel != NULL) {
+        if((emulator->blocking_channels & (1 << port)) != 0) {
+            emulator->regs[A] = pi_ring_pop(&channel->in);
+        } else {
+            pi_ring_try_pop(&channel->in, &emulator->regs[A]);
+        }
     } else if(emulator->ports[port].reader != NULL) {
+        const uint64_t start = now_ns();
+
         emulator->regs[A] = emulator->ports[port].reader();
+
+        pi_metrics_add(
+            &emulator->metrics.port_callback_ns[port], now_ns() - start
+        );
     }
 }
@@ -0,0 +1,568 @@
+#define _GNU_SOURCE
+
+#include "../include/log.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Records per thread, may be set at build time. Must be a power of two */
+#ifndef PLG_BUFFER_LEN
+    #define PLG_BUFFER_LEN 256
+#endif
+
+static_assert(
+    PLG_BUFFER_LEN > 1 && (PLG_BUFFER_LEN & (PLG_BUFFER_LEN - 1)) == 0,
+    "PLG_BUFFER_LEN must be a power of two"
+);
+
+/*
+ * The writer wakes up every `PLG_FLUSH_MS`, or as soon as a buffer fills up
+ * to `PLG_HIGH_WATER` records
+ */
+#define PLG_FLUSH_MS    10
+#define PLG_HIGH_WATER  (PLG_BUFFER_LEN / 2)
+
+#define PLG_LINE_LEN    512
+
+#if defined(PLG_LOGLEVEL_INFO)
+    #define PLG_DEFAULT_LEVEL PLG_LEVEL_INFO
+#elif defined(PLG_LOGLEVEL_WARN)
+    #define PLG_DEFAULT_LEVEL PLG_LEVEL_WARN
+#elif defined(PLG_LOGLEVEL_ERROR)
+    #define PLG_DEFAULT_LEVEL PLG_LEVEL_ERROR
+#else
+    #define PLG_DEFAULT_LEVEL PLG_LEVEL_FATAL
+#endif
+
+_Atomic int plg_level = PLG_DEFAULT_LEVEL;
+
+/* String arguments hold an offset into `strings` instead of a pointer */
+struct plg_record_t {
+    const struct plg_site_t *site;
+
+    /* CLOCK_MONOTONIC time and thread of the call to `plg_submit` */
+    uint64_t time_ns;
+    pid_t tid;
+
+    uint8_t args_len;
+    struct plg_arg_t args[PLG_MAX_ARGS];
+
+    char strings[PLG_STR_LEN];
+};
+
+/*
+ * Single-producer/single-consumer buffer, filled by its thread and drained
+ * by the writer. Records are dropped rather than waited on when it is full.
+ */
+struct plg_buffer_t {
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+
+    _Atomic uint64_t dropped;
+
+    /* Set once the owning thread has exited */
+    _Atomic int dead;
+
+    struct plg_buffer_t *next;
+
+    /* Owning thread, for the records about the buffer itself */
+    pid_t tid;
+
+    /* Records `drain_all` is merging, protected by `buffers_lock` */
+    uint32_t drain_tail;
+    uint32_t drain_head;
+
+    struct plg_record_t records[PLG_BUFFER_LEN];
+};
+
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct plg_buffer_t *buffers = NULL;
+
+static pthread_once_t buffer_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t buffer_key;
+
+static _Thread_local struct plg_buffer_t *thread_buffer = NULL;
+
+/*
+ * Set once the buffer of the thread has been handed over to the writer, which
+ * may free it at any time. Records submitted afterwards (e.g. from other
+ * thread-specific data destructors) are written synchronously.
+ */
+static _Thread_local int thread_exiting = 0;
+
+static _Thread_local pid_t thread_id = 0;
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    _Atomic int running;
+    int stopping;
+    int kicked;
+} writer = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static const char *level_names[] = {
+    [PLG_LEVEL_INFO]  = "INFO",
+    [PLG_LEVEL_WARN]  = "WARN",
+    [PLG_LEVEL_ERROR] = "ERROR",
+    [PLG_LEVEL_FATAL] = "FATAL",
+};
+
+/* ========================================================================== */
+/* ================================ Formatting ============================== */
+/* ========================================================================== */
+
+static size_t append(char *line, size_t len, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static size_t append(char *line, size_t len, const char *fmt, ...) {
+    if(len >= PLG_LINE_LEN) { return len; }
+
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(line + len, PLG_LINE_LEN - len, fmt, args);
+    va_end(args);
+
+    if(n < 0) { return len; }
+
+    return (len + n < PLG_LINE_LEN) ? len + n : PLG_LINE_LEN - 1;
+}
+
+static size_t format_arg(
+    char *line,
+    size_t len,
+    const char *spec,
+    char conv,
+    const struct plg_arg_t *arg,
+    const char *strings
+) {
+    char full[32];
+
+    switch(arg->kind) {
+        case PLG_ARG_INT:
+        case PLG_ARG_UINT:
+            if(conv == 'c') {
+                snprintf(full, sizeof(full), "%sc", spec);
+                return append(line, len, full, (int)arg->i);
+            }
+            if(strchr("diouxX", conv) == NULL) {
+                conv = (arg->kind == PLG_ARG_INT) ? 'd' : 'u';
+            }
+            snprintf(full, sizeof(full), "%sll%c", spec, conv);
+            return (arg->kind == PLG_ARG_INT && (conv == 'd' || conv == 'i'))
+                ? append(line, len, full, arg->i)
+                : append(line, len, full, arg->u);
+        case PLG_ARG_DOUBLE:
+            if(strchr("fFeEgGaA", conv) == NULL) { conv = 'g'; }
+            snprintf(full, sizeof(full), "%s%c", spec, conv);
+            return append(line, len, full, arg->d);
+        case PLG_ARG_STR:
+            snprintf(full, sizeof(full), "%ss", spec);
+            return append(line, len, full, strings + arg->u);
+        case PLG_ARG_PTR:
+        default:
+            return append(line, len, "%p", arg->p);
+    }
+}
+
+/*
+ * Re-runs the format of a record, calling snprintf once per conversion with
+ * the length modifier matching the captured argument
+ */
+static void format_record(const struct plg_record_t *record, FILE *file) {
+    const struct plg_site_t *site = record->site;
+
+    char line[PLG_LINE_LEN];
+    size_t len = append(
+        line, 0, "%s: %llu.%06llu [%d] %s@%d: ",
+        level_names[site->level],
+        (unsigned long long)(record->time_ns / 1000000000),
+        (unsigned long long)(record->time_ns % 1000000000 / 1000),
+        (int)record->tid, site->file, site->line
+    );
+
+    uint8_t arg = 0;
+
+    for(const char *it = site->fmt; *it != '\0' && len < PLG_LINE_LEN - 1;) {
+        if(*it != '%') {
+            line[len++] = *it++;
+            continue;
+        }
+
+        if(it[1] == '%') {
+            line[len++] = '%';
+            it += 2;
+            continue;
+        }
+
+        /* Flags, width and precision are kept, length modifiers dropped */
+        char spec[16] = "%";
+        size_t spec_len = 1;
+
+        for(++it; *it != '\0' && strchr("-+ #0123456789.", *it); ++it) {
+            if(spec_len < sizeof(spec) - 1) { spec[spec_len++] = *it; }
+        }
+        while(*it != '\0' && strchr("hlLqjzt", *it)) { ++it; }
+
+        spec[spec_len] = '\0';
+
+        if(*it == '\0') { break; }
+
+        const char conv = *it++;
+
+        if(arg < record->args_len) {
+            len = format_arg(
+                line, len, spec, conv, &record->args[arg++], record->strings
+            );
+        }
+    }
+
+    line[len] = '\0';
+
+    fprintf(file, "%s\n", line);
+}
+
+/* ========================================================================== */
+/* ================================= Buffers ================================ */
+/* ========================================================================== */
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static inline pid_t current_tid(void) {
+    if(thread_id == 0) { thread_id = gettid(); }
+
+    return thread_id;
+}
+
+/* Warnings about the logger itself, laid out like formatted records */
+static void warn_internal(FILE *file, pid_t tid, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void warn_internal(
+    FILE *file,
+    pid_t tid,
+    int line,
+    const char *fmt,
+    ...
+) {
+    const uint64_t time_ns = now_ns();
+
+    fprintf(
+        file, "WARN: %llu.%06llu [%d] %s@%d: log: ",
+        (unsigned long long)(time_ns / 1000000000),
+        (unsigned long long)(time_ns % 1000000000 / 1000),
+        (int)tid, __FILE__, line
+    );
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(file, fmt, args);
+    va_end(args);
+
+    fputc('\n', file);
+}
+
+static void capture(
+    struct plg_record_t *record,
+    const struct plg_site_t *site,
+    const struct plg_arg_t *args,
+    uint8_t args_len
+) {
+    /* Always leaves room for at least a terminator */
+    size_t strings_len = 0;
+
+    record->site = site;
+    record->time_ns = now_ns();
+    record->tid = current_tid();
+    record->args_len = args_len < PLG_MAX_ARGS ? args_len : PLG_MAX_ARGS;
+
+    for(uint8_t i = 0; i < record->args_len; ++i) {
+        record->args[i] = args[i];
+
+        if(args[i].kind != PLG_ARG_STR) { continue; }
+
+        const char *s = args[i].s ? args[i].s : "(null)";
+        const size_t n = strnlen(s, PLG_STR_LEN - strings_len - 1);
+
+        memcpy(record->strings + strings_len, s, n);
+        record->strings[strings_len + n] = '\0';
+
+        record->args[i].u = strings_len;
+
+        strings_len += n + 1;
+        if(strings_len > PLG_STR_LEN - 1) { strings_len = PLG_STR_LEN - 1; }
+    }
+}
+
+/* Runs on the exiting thread itself, before its thread-locals go away */
+static void mark_dead(void *buffer) {
+    thread_buffer = NULL;
+    thread_exiting = 1;
+
+    atomic_store_explicit(
+        &((struct plg_buffer_t *)buffer)->dead, 1, memory_order_release
+    );
+}
+
+static void create_buffer_key(void) {
+    pthread_key_create(&buffer_key, mark_dead);
+}
+
+static struct plg_buffer_t *get_thread_buffer(void) {
+    if(thread_buffer != NULL) { return thread_buffer; }
+    if(thread_exiting)        { return NULL; }
+
+    struct plg_buffer_t *buffer = calloc(1, sizeof(*buffer));
+    if(!buffer) { return NULL; }
+
+    buffer->tid = current_tid();
+
+    pthread_once(&buffer_key_once, create_buffer_key);
+    pthread_setspecific(buffer_key, buffer);
+
+    pthread_mutex_lock(&buffers_lock);
+    buffer->next = buffers;
+    buffers = buffer;
+    pthread_mutex_unlock(&buffers_lock);
+
+    thread_buffer = buffer;
+
+    return buffer;
+}
+
+/* Returns non-zero if any record was dropped since the last call */
+static int report_dropped(struct plg_buffer_t *buffer, FILE *file) {
+    const uint64_t dropped =
+        atomic_exchange_explicit(&buffer->dropped, 0, memory_order_relaxed);
+    if(dropped != 0) {
+        warn_internal(
+            file, buffer->tid, __LINE__, "dropped %llu records",
+            (unsigned long long)dropped
+        );
+    }
+
+    return dropped != 0;
+}
+
+/*
+ * Drains every buffer and frees those of exited threads. Each buffer is in
+ * submission order already, the records published so far are merged by time
+ * so that the output of different threads interleaves as it happened.
+ */
+static void drain_all(FILE *file) {
+    int written = 0;
+
+    pthread_mutex_lock(&buffers_lock);
+
+    for(struct plg_buffer_t *it = buffers; it != NULL; it = it->next) {
+        it->drain_tail = atomic_load_explicit(&it->tail, memory_order_relaxed);
+        it->drain_head = atomic_load_explicit(&it->head, memory_order_acquire);
+    }
+
+    for(;;) {
+        struct plg_buffer_t *next = NULL;
+        const struct plg_record_t *record = NULL;
+
+        for(struct plg_buffer_t *it = buffers; it != NULL; it = it->next) {
+            if(it->drain_tail == it->drain_head) { continue; }
+
+            const struct plg_record_t *candidate =
+                &it->records[it->drain_tail & (PLG_BUFFER_LEN - 1)];
+
+            if(record == NULL || candidate->time_ns < record->time_ns) {
+                next = it;
+                record = candidate;
+            }
+        }
+
+        if(next == NULL) { break; }
+
+        format_record(record, file);
+        written = 1;
+
+        /* Hands the slot back right away, the producer may be waiting on it */
+        atomic_store_explicit(
+            &next->tail, ++next->drain_tail, memory_order_release
+        );
+    }
+
+    for(struct plg_buffer_t **it = &buffers; *it != NULL;) {
+        struct plg_buffer_t *buffer = *it;
+
+        const int dead =
+            atomic_load_explicit(&buffer->dead, memory_order_acquire);
+
+        written |= report_dropped(buffer, file);
+
+        /* Nothing can be published past `drain_head` once it is dead */
+        if(dead && buffer->drain_head == atomic_load_explicit(
+            &buffer->head, memory_order_relaxed
+        )) {
+            *it = buffer->next;
+            free(buffer);
+        } else {
+            it = &buffer->next;
+        }
+    }
+
+    pthread_mutex_unlock(&buffers_lock);
+
+    if(written) { fflush(file); }
+}
+
+/* ========================================================================== */
+/* ================================= Writer ================================= */
+/* ========================================================================== */
+
+static void *writer_loop(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&writer.lock);
+
+    while(!writer.stopping) {
+        if(!writer.kicked) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+
+            deadline.tv_nsec += PLG_FLUSH_MS * 1000000L;
+            if(deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec  += 1;
+                deadline.tv_nsec -= 1000000000;
+            }
+
+            pthread_cond_timedwait(&writer.cond, &writer.lock, &deadline);
+        }
+
+        writer.kicked = 0;
+
+        pthread_mutex_unlock(&writer.lock);
+        drain_all(stderr);
+        pthread_mutex_lock(&writer.lock);
+    }
+
+    pthread_mutex_unlock(&writer.lock);
+
+    drain_all(stderr);
+
+    return NULL;
+}
+
+void plg_set_level(enum plg_level_t level) {
+    if(level > PLG_LEVEL_FATAL) { level = PLG_LEVEL_FATAL; }
+
+    atomic_store_explicit(&plg_level, level, memory_order_relaxed);
+}
+
+enum plg_level_t plg_get_level(void) {
+    return atomic_load_explicit(&plg_level, memory_order_relaxed);
+}
+
+void plg_start(void) {
+    pthread_mutex_lock(&writer.lock);
+
+    if(atomic_load_explicit(&writer.running, memory_order_relaxed)) {
+        pthread_mutex_unlock(&writer.lock);
+        return;
+    }
+
+    writer.stopping = 0;
+
+    if(pthread_create(&writer.thread, NULL, writer_loop, NULL) != 0) {
+        pthread_mutex_unlock(&writer.lock);
+
+        warn_internal(
+            stderr, current_tid(), __LINE__, "failed to start the writer"
+        );
+        return;
+    }
+
+    atomic_store_explicit(&writer.running, 1, memory_order_release);
+
+    pthread_mutex_unlock(&writer.lock);
+}
+
+void plg_stop(void) {
+    pthread_mutex_lock(&writer.lock);
+
+    if(!atomic_load_explicit(&writer.running, memory_order_relaxed)) {
+        pthread_mutex_unlock(&writer.lock);
+        return;
+    }
+
+    /* Records submitted from now on are written synchronously */
+    atomic_store_explicit(&writer.running, 0, memory_order_release);
+
+    writer.stopping = 1;
+    pthread_cond_signal(&writer.cond);
+
+    pthread_mutex_unlock(&writer.lock);
+
+    pthread_join(writer.thread, NULL);
+}
+
+void plg_submit(
+    const struct plg_site_t *site,
+    const struct plg_arg_t *args,
+    uint8_t args_len
+) {
+    struct plg_buffer_t *buffer = NULL;
+
+    if(site->level != PLG_LEVEL_FATAL
+            && atomic_load_explicit(&writer.running, memory_order_acquire)) {
+        buffer = get_thread_buffer();
+    }
+
+    if(buffer == NULL) {
+        struct plg_record_t record;
+        capture(&record, site, args, args_len);
+
+        /* Whatever is still buffered happened before this record */
+        if(site->level == PLG_LEVEL_FATAL) { plg_stop(); }
+
+        drain_all(stderr);
+        format_record(&record, stderr);
+
+        return;
+    }
+
+    const uint32_t head =
+        atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    const uint32_t tail =
+        atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+    if(head - tail == PLG_BUFFER_LEN) {
+        atomic_fetch_add_explicit(&buffer->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    capture(
+        &buffer->records[head & (PLG_BUFFER_LEN - 1)], site, args, args_len
+    );
+
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+
+    /* Only once per crossing, the buffer fills up one record at a time */
+    if(head + 1 - tail == PLG_HIGH_WATER) {
+        pthread_mutex_lock(&writer.lock);
+        writer.kicked = 1;
+        pthread_cond_signal(&writer.cond);
+        pthread_mutex_unlock(&writer.lock);
+
+        /* Lets the writer in when it shares the CPU with this thread */
+        sched_yield();
+    }
+}
@@ -1,4 +1,5 @@
 #include "../include/emulator.h"
+#include "../include/log.h"
 
 #include <stdio.h>
 
@@ -15,6 +16,8 @@ void writer(uint8_t value) {
 }
 
 int main(void) {
+    plg_start();
+
     struct pi_port_t ports[PORTS_LEN];
     for(size_t i = 0; i < PORTS_LEN; ++i) {
         ports[i].reader = reader;
@@ -36,5 +39,7 @@ int main(void) {
 
     pi_emulator_execute(&emulator);
 
+    plg_stop();
+
     return 0;
 }
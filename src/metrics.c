@@ -0,0 +1,297 @@
+#define _GNU_SOURCE
+
+#include "../include/metrics.h"
+
+#include "../include/log.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Protected by `registry_lock` */
+static struct pi_metrics_t *attached = NULL;
+static struct pi_metrics_snapshot_t detached = { 0 };
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    int running;
+    char *path;
+    uint32_t interval_ms;
+} exporter = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static inline uint64_t load(_Atomic uint64_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static void accumulate(
+    struct pi_metrics_snapshot_t *snapshot,
+    struct pi_metrics_t *metrics
+) {
+    snapshot->retired      += load(&metrics->retired);
+    snapshot->halts        += load(&metrics->halts);
+    snapshot->random_bytes += load(&metrics->random_bytes);
+
+    for(uint16_t i = 0; i < PORTS_LEN; ++i) {
+        snapshot->port_reads[i]       += load(&metrics->port_reads[i]);
+        snapshot->port_writes[i]      += load(&metrics->port_writes[i]);
+        snapshot->port_callback_ns[i] += load(&metrics->port_callback_ns[i]);
+    }
+}
+
+/* ========================================================================== */
+/* ============================ Metrics Functions =========================== */
+/* ========================================================================== */
+
+void pi_metrics_attach(struct pi_emulator_t *emulator) {
+    if(!emulator) { PLG_FATAL("metrics_attach: emulator is NULL"); }
+
+    struct pi_metrics_t *metrics = &emulator->metrics;
+
+    pthread_mutex_lock(&registry_lock);
+
+    if(!metrics->attached) {
+        metrics->attached = 1;
+        metrics->prev = NULL;
+        metrics->next = attached;
+        if(attached != NULL) { attached->prev = metrics; }
+        attached = metrics;
+    }
+
+    pthread_mutex_unlock(&registry_lock);
+}
+
+void pi_metrics_detach(struct pi_emulator_t *emulator) {
+    if(!emulator) { PLG_FATAL("metrics_detach: emulator is NULL"); }
+
+    struct pi_metrics_t *metrics = &emulator->metrics;
+
+    pthread_mutex_lock(&registry_lock);
+
+    if(!metrics->attached) {
+        pthread_mutex_unlock(&registry_lock);
+        return;
+    }
+
+    if(metrics->prev != NULL) { metrics->prev->next = metrics->next; }
+    if(metrics->next != NULL) { metrics->next->prev = metrics->prev; }
+    if(attached == metrics)   { attached = metrics->next; }
+
+    accumulate(&detached, metrics);
+
+    pthread_mutex_unlock(&registry_lock);
+
+    memset(metrics, 0x00, sizeof(*metrics));
+}
+
+int pi_metrics_is_attached(const struct pi_emulator_t *emulator) {
+    if(!emulator) { PLG_FATAL("metrics_is_attached: emulator is NULL"); }
+
+    int found = 0;
+
+    pthread_mutex_lock(&registry_lock);
+
+    for(struct pi_metrics_t *it = attached; it != NULL; it = it->next) {
+        if(it == &emulator->metrics) {
+            found = 1;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&registry_lock);
+
+    return found;
+}
+
+void pi_metrics_snapshot(struct pi_metrics_snapshot_t *snapshot) {
+    if(!snapshot) { PLG_FATAL("metrics_snapshot: snapshot is NULL"); }
+
+    pthread_mutex_lock(&registry_lock);
+
+    *snapshot = detached;
+    snapshot->instances = 0;
+
+    for(struct pi_metrics_t *it = attached; it != NULL; it = it->next) {
+        accumulate(snapshot, it);
+
+        ++snapshot->instances;
+    }
+
+    pthread_mutex_unlock(&registry_lock);
+}
+
+void pi_metrics_write(
+    FILE *file,
+    const struct pi_metrics_snapshot_t *snapshot
+) {
+    if(!file)     { PLG_FATAL("metrics_write: file is NULL"); }
+    if(!snapshot) { PLG_FATAL("metrics_write: snapshot is NULL"); }
+
+    fprintf(
+        file,
+        "# HELP pi_instances Emulators attached to the metrics.\n"
+        "# TYPE pi_instances gauge\n"
+        "pi_instances %llu\n"
+        "# HELP pi_instructions_retired_total Instructions retired.\n"
+        "# TYPE pi_instructions_retired_total counter\n"
+        "pi_instructions_retired_total %llu\n"
+        "# HELP pi_halts_total HLT instructions executed.\n"
+        "# TYPE pi_halts_total counter\n"
+        "pi_halts_total %llu\n"
+        "# HELP pi_random_bytes_total Bytes drawn from the random port.\n"
+        "# TYPE pi_random_bytes_total counter\n"
+        "pi_random_bytes_total %llu\n",
+        (unsigned long long)snapshot->instances,
+        (unsigned long long)snapshot->retired,
+        (unsigned long long)snapshot->halts,
+        (unsigned long long)snapshot->random_bytes
+    );
+
+    fprintf(
+        file,
+        "# HELP pi_port_reads_total PLD instructions executed, per port.\n"
+        "# TYPE pi_port_reads_total counter\n"
+    );
+    for(uint16_t i = 0; i < PORTS_LEN; ++i) {
+        fprintf(
+            file, "pi_port_reads_total{port=\"%u\"} %llu\n",
+            (unsigned)i, (unsigned long long)snapshot->port_reads[i]
+        );
+    }
+
+    fprintf(
+        file,
+        "# HELP pi_port_writes_total PST instructions executed, per port.\n"
+        "# TYPE pi_port_writes_total counter\n"
+    );
+    for(uint16_t i = 0; i < PORTS_LEN; ++i) {
+        fprintf(
+            file, "pi_port_writes_total{port=\"%u\"} %llu\n",
+            (unsigned)i, (unsigned long long)snapshot->port_writes[i]
+        );
+    }
+
+    fprintf(
+        file,
+        "# HELP pi_port_callback_seconds_total Time spent in port callbacks.\n"
+        "# TYPE pi_port_callback_seconds_total counter\n"
+    );
+    for(uint16_t i = 0; i < PORTS_LEN; ++i) {
+        fprintf(
+            file, "pi_port_callback_seconds_total{port=\"%u\"} %.9f\n",
+            (unsigned)i, (double)snapshot->port_callback_ns[i] / 1e9
+        );
+    }
+}
+
+/* ========================================================================== */
+/* ================================ Exporter ================================ */
+/* ========================================================================== */
+
+static void export_once(const char *path) {
+    struct pi_metrics_snapshot_t snapshot;
+    pi_metrics_snapshot(&snapshot);
+
+    const size_t len = strlen(path);
+
+    char *tmp_path = malloc(len + sizeof(".tmp"));
+    if(!tmp_path) { PLG_FATAL("metrics_export: out of memory"); }
+
+    memcpy(tmp_path, path, len);
+    memcpy(tmp_path + len, ".tmp", sizeof(".tmp"));
+
+    FILE *file = fopen(tmp_path, "w");
+    if(!file) {
+        PLG_WARN("metrics_export: failed to open the temporary file");
+
+        free(tmp_path);
+        return;
+    }
+
+    pi_metrics_write(file, &snapshot);
+
+    if(fclose(file) != 0 || rename(tmp_path, path) != 0) {
+        PLG_WARN("metrics_export: failed to write the metrics file");
+    }
+
+    free(tmp_path);
+}
+
+static void *export_loop(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&exporter.lock);
+
+    while(exporter.running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+
+        deadline.tv_sec  += exporter.interval_ms / 1000;
+        deadline.tv_nsec += (long)(exporter.interval_ms % 1000) * 1000000;
+        if(deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec  += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while(exporter.running && pthread_cond_timedwait(
+            &exporter.cond, &exporter.lock, &deadline
+        ) == 0) {}
+
+        export_once(exporter.path);
+    }
+
+    pthread_mutex_unlock(&exporter.lock);
+
+    return NULL;
+}
+
+void pi_metrics_export_start(const char *path, uint32_t interval_ms) {
+    if(!path)            { PLG_FATAL("metrics_export_start: path is NULL"); }
+    if(interval_ms == 0) { PLG_FATAL("metrics_export_start: interval is 0"); }
+
+    pthread_mutex_lock(&exporter.lock);
+
+    if(exporter.running) {
+        PLG_FATAL("metrics_export_start: exporter is already running");
+    }
+
+    exporter.path = strdup(path);
+    if(!exporter.path) { PLG_FATAL("metrics_export_start: out of memory"); }
+
+    exporter.interval_ms = interval_ms;
+    exporter.running = 1;
+
+    pthread_mutex_unlock(&exporter.lock);
+
+    if(pthread_create(&exporter.thread, NULL, export_loop, NULL) != 0) {
+        PLG_FATAL("metrics_export_start: failed to create the thread");
+    }
+}
+
+void pi_metrics_export_stop(void) {
+    pthread_mutex_lock(&exporter.lock);
+
+    if(!exporter.running) {
+        pthread_mutex_unlock(&exporter.lock);
+        return;
+    }
+
+    exporter.running = 0;
+    pthread_cond_signal(&exporter.cond);
+
+    pthread_mutex_unlock(&exporter.lock);
+
+    /* The final snapshot is written by the thread on its way out */
+    pthread_join(exporter.thread, NULL);
+
+    free(exporter.path);
+    exporter.path = NULL;
+}
@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+
+#include "../include/pool.h"
+
+#include "../include/log.h"
+#include "../include/metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define POOL_STRIDE \
+    ((sizeof(struct pi_emulator_t) + PI_CACHE_LINE - 1) & ~(PI_CACHE_LINE - 1))
+
+static void *grow(void *array, size_t *cap, size_t elem_size) {
+    *cap = (*cap == 0) ? PI_POOL_SLAB_LEN : *cap * 2;
+
+    array = realloc(array, *cap * elem_size);
+    if(!array) { PLG_FATAL("pool: out of memory"); }
+
+    return array;
+}
+
+static void add_slab(struct pi_pool_t *pool) {
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t align = pool->hugepages ? PI_HUGEPAGE_SIZE : page;
+
+    size_t size = POOL_STRIDE * PI_POOL_SLAB_LEN;
+    size = (size + align - 1) & ~(align - 1);
+
+    /*
+     * mmap only guarantees page alignment, and a huge page can only back a
+     * 2 MiB-aligned range. The slab is carved out of a larger mapping, whose
+     * unused head and tail are unmapped.
+     */
+    const size_t mapped = size + align - page;
+
+    uint8_t *raw = mmap(
+        NULL, mapped,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+        -1, 0
+    );
+    if(raw == MAP_FAILED) { PLG_FATAL("pool: failed to mmap slab"); }
+
+    /*
+     * Pages are page-aligned, hence cache-line-aligned, and come zeroed, so
+     * instances only need their descriptor to be initialized
+     */
+    uint8_t *base =
+        (uint8_t *)(((uintptr_t)raw + align - 1) & ~(uintptr_t)(align - 1));
+
+    if(base != raw) { munmap(raw, base - raw); }
+    if(base + size != raw + mapped) {
+        munmap(base + size, (raw + mapped) - (base + size));
+    }
+
+    if(((uintptr_t)base & (align - 1)) != 0) {
+        PLG_FATAL("pool: slab is not aligned");
+    }
+
+    if(pool->hugepages && madvise(base, size, MADV_HUGEPAGE) != 0) {
+        PLG_WARN("pool: transparent hugepages are unavailable");
+    }
+
+    if(pool->slabs_len == pool->slabs_cap) {
+        pool->slabs = grow(
+            pool->slabs, &pool->slabs_cap, sizeof(*pool->slabs)
+        );
+    }
+
+    pool->slabs[pool->slabs_len++] = (struct pi_pool_slab_t){
+        .base = base,
+        .size = size,
+    };
+
+    const size_t count = size / POOL_STRIDE;
+
+    /* Acquired instances count too, they all come back on release */
+    pool->instances += count;
+    while(pool->free_cap < pool->instances) {
+        pool->free = grow(pool->free, &pool->free_cap, sizeof(*pool->free));
+    }
+
+    /* Pushed in reverse so that instances are handed out in address order */
+    for(size_t i = count; i-- > 0;) {
+        struct pi_emulator_t *emulator =
+            (struct pi_emulator_t *)(base + i * POOL_STRIDE);
+
+        emulator->urandom_fd = pool->urandom_fd;
+
+        pool->free[pool->free_len++] = emulator;
+    }
+}
+
+/* ========================================================================== */
+/* ============================= Pool Functions ============================= */
+/* ========================================================================== */
+
+void pi_pool_init(struct pi_pool_t *pool, int hugepages) {
+    if(!pool) { PLG_FATAL("pool_init: pool is NULL"); }
+
+    memset(pool, 0x00, sizeof(*pool));
+
+    pool->hugepages = hugepages;
+
+    pool->urandom_fd = open("/dev/urandom", O_RDONLY);
+    if(pool->urandom_fd < 0) {
+        PLG_FATAL("pool_init: failed to open `/dev/urandom`");
+    }
+}
+
+void pi_pool_destroy(struct pi_pool_t *pool) {
+    if(!pool) { PLG_FATAL("pool_destroy: pool is NULL"); }
+
+    for(size_t i = 0; i < pool->slabs_len; ++i) {
+        uint8_t *base = pool->slabs[i].base;
+
+        /* Instances still acquired may be attached */
+        for(size_t j = 0; j < pool->slabs[i].size / POOL_STRIDE; ++j) {
+            pi_metrics_detach((struct pi_emulator_t *)(base + j * POOL_STRIDE));
+        }
+
+        munmap(pool->slabs[i].base, pool->slabs[i].size);
+    }
+
+    free(pool->slabs);
+    free(pool->free);
+
+    close(pool->urandom_fd);
+
+    memset(pool, 0x00, sizeof(*pool));
+}
+
+void pi_pool_reserve(struct pi_pool_t *pool, size_t count) {
+    if(!pool) { PLG_FATAL("pool_reserve: pool is NULL"); }
+
+    while(pool->free_len < count) { add_slab(pool); }
+}
+
+struct pi_emulator_t *pi_pool_acquire(struct pi_pool_t *pool) {
+    if(!pool) { PLG_FATAL("pool_acquire: pool is NULL"); }
+
+    if(pool->free_len == 0) { add_slab(pool); }
+
+    return pool->free[--pool->free_len];
+}
+
+void pi_pool_release(struct pi_pool_t *pool, struct pi_emulator_t *emulator) {
+    if(!pool)     { PLG_FATAL("pool_release: pool is NULL"); }
+    if(!emulator) { PLG_FATAL("pool_release: emulator is NULL"); }
+
+    pi_metrics_detach(emulator);
+    pi_emulator_reset(emulator);
+
+    emulator->blocking_channels = 0;
+    memset(emulator->ports, 0x00, sizeof(emulator->ports));
+    memset(emulator->channels, 0x00, sizeof(emulator->channels));
+
+    /* Can't overflow, `add_slab` keeps room for every instance */
+    pool->free[pool->free_len++] = emulator;
+}
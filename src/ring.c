@@ -0,0 +1,184 @@
+#define _GNU_SOURCE
+
+#include "../include/ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+_Atomic int pi_ring_asymmetric = 0;
+
+/*
+ * The futexes are not private since the rings are shared between processes.
+ * Spurious returns (EINTR, EAGAIN, timeouts) are fine, callers re-check the
+ * ring.
+ */
+static inline void futex_wait(
+    _Atomic uint32_t *word,
+    uint32_t expected,
+    const struct timespec *timeout
+) {
+    syscall(
+        SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, timeout, NULL, 0
+    );
+}
+
+void pi_ring_wake(_Atomic uint32_t *word) {
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/*
+ * Orders the caller's increment of `waiters` before its next loads, on this
+ * side and on every running thread of the registered processes, i.e. the
+ * other side whenever it skips the fence in `pi_ring_notify`.
+ *
+ * Returns zero when membarrier(2) is unavailable. The other side may still
+ * skip its fence, so the caller must then not sleep without a timeout.
+ */
+static inline int barrier_all(void) {
+    return syscall(SYS_membarrier, MEMBARRIER_CMD_GLOBAL_EXPEDITED, 0, 0) == 0;
+}
+
+/* Bounds how long a wakeup can be missed for when `barrier_all` fails */
+static const struct timespec poll_timeout = { .tv_nsec = 1000000 };
+
+void pi_ring_wait_push(struct pi_ring_t *ring, uint8_t value) {
+    while(!pi_ring_try_push(ring, value)) {
+        atomic_fetch_add_explicit(&ring->waiters, 1, memory_order_seq_cst);
+
+        const int synced = barrier_all();
+
+        const uint32_t head =
+            atomic_load_explicit(&ring->head, memory_order_relaxed);
+        const uint32_t tail =
+            atomic_load_explicit(&ring->tail, memory_order_seq_cst);
+
+        if(head - tail == PI_RING_LEN) {
+            futex_wait(&ring->tail, tail, synced ? NULL : &poll_timeout);
+        }
+
+        atomic_fetch_sub_explicit(&ring->waiters, 1, memory_order_relaxed);
+    }
+}
+
+uint8_t pi_ring_wait_pop(struct pi_ring_t *ring) {
+    uint8_t value;
+
+    while(!pi_ring_try_pop(ring, &value)) {
+        atomic_fetch_add_explicit(&ring->waiters, 1, memory_order_seq_cst);
+
+        const int synced = barrier_all();
+
+        const uint32_t tail =
+            atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        const uint32_t head =
+            atomic_load_explicit(&ring->head, memory_order_seq_cst);
+
+        if(head == tail) {
+            futex_wait(&ring->head, head, synced ? NULL : &poll_timeout);
+        }
+
+        atomic_fetch_sub_explicit(&ring->waiters, 1, memory_order_relaxed);
+    }
+
+    return value;
+}
+
+/* ========================================================================== */
+/* ============================ Channel Functions =========================== */
+/* ========================================================================== */
+
+struct pi_channel_t *pi_channel_map(int fd) {
+    struct stat st;
+
+    /* Registering twice is harmless, failing leaves the fences in place */
+    if(!atomic_load_explicit(&pi_ring_asymmetric, memory_order_relaxed)) {
+        if(syscall(
+            SYS_membarrier, MEMBARRIER_CMD_REGISTER_GLOBAL_EXPEDITED, 0, 0
+        ) == 0) {
+            atomic_store_explicit(&pi_ring_asymmetric, 1, memory_order_relaxed);
+        }
+    }
+
+    if(fstat(fd, &st) != 0) { return NULL; }
+
+    /* A freshly grown file reads as zeroes, i.e. two empty rings */
+    if((size_t)st.st_size < sizeof(struct pi_channel_t)) {
+        if(ftruncate(fd, sizeof(struct pi_channel_t)) != 0) { return NULL; }
+    }
+
+    void *channel = mmap(
+        NULL, sizeof(struct pi_channel_t),
+        PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd, 0
+    );
+    if(channel == MAP_FAILED) { return NULL; }
+
+    return channel;
+}
+
+struct pi_channel_t *pi_channel_create(const char *name) {
+    if(!name) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(fd < 0) { return NULL; }
+
+    struct pi_channel_t *channel = pi_channel_map(fd);
+
+    /* Don't leave a half-created object behind */
+    const int error = errno;
+
+    close(fd);
+    if(!channel) { shm_unlink(name); }
+
+    errno = error;
+
+    return channel;
+}
+
+struct pi_channel_t *pi_channel_open(const char *name) {
+    if(!name) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    const int fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0) { return NULL; }
+
+    struct pi_channel_t *channel = pi_channel_map(fd);
+
+    const int error = errno;
+
+    close(fd);
+
+    errno = error;
+
+    return channel;
+}
+
+int pi_channel_unmap(struct pi_channel_t *channel) {
+    if(!channel) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return munmap(channel, sizeof(struct pi_channel_t));
+}
+
+int pi_channel_destroy(const char *name) {
+    if(!name) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return shm_unlink(name);
+}
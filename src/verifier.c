@@ -0,0 +1,189 @@
+#include "../include/emulator.h"
+
+#include "../include/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The verifier walks the control flow of a program from its first
+ * instruction, following every branch both ways. Calls are followed into
+ * their callee (one level deeper) and resume after the call site, assuming
+ * the callee returns. A program is verified if every reachable instruction:
+ *
+ *  - never moves `inst_ptr` past the end of the program, so that stepping
+ *    needs no `% MAX_PROGRAM_LEN`;
+ *  - never calls deeper than `CALLSTACK_LEN - 1` nor returns from the top
+ *    level, so that calls and returns need no `% CALLSTACK_LEN`;
+ *  - never targets r0 with a guarded register write.
+ *
+ * Recursion fails the depth check. Note that `inst_ptr` is incremented after
+ * jumps, calls and returns too, hence the `+ 1` on every target below.
+ */
+
+#define BITMAP_WORD(i) ((i) / 64)
+#define BITMAP_MASK(i) (UINT64_C(1) << ((i) % 64))
+
+#define HEIGHT_UNKNOWN 0xFF
+
+struct verifier_t {
+    struct pi_proof_t *proof;
+    const uint16_t *program;
+
+    /* Extra call depth below each procedure, indexed by entry */
+    uint8_t height[MAX_PROGRAM_LEN];
+
+    /* One worklist per call depth, each instruction is pushed at most once */
+    uint16_t worklist[CALLSTACK_LEN][MAX_PROGRAM_LEN];
+};
+
+static inline int fail(struct verifier_t *verifier, uint16_t inst_ptr) {
+    verifier->proof->failed_at = inst_ptr;
+
+    return -1;
+}
+
+/* Returns non-zero if the instruction writes a register it guards against r0 */
+static inline int writes_r0(uint16_t instruction) {
+    const uint16_t A = (instruction >> 8) & 0x07;
+    const uint16_t C = (instruction >> 5) & 0x07;
+
+    switch((enum pi_opcode_t)(instruction >> 11)) {
+        case PIOP_LDI:  case PIOP_MOV:  case PIOP_ADDI: case PIOP_ADSI:
+        case PIOP_XORI: case PIOP_ANDI: case PIOP_ORI:  case PIOP_RSHI:
+        case PIOP_LSHI: case PIOP_RTLI: case PIOP_ARSI:
+            return A == 0;
+        case PIOP_ADD:  case PIOP_SUB:  case PIOP_XOR:  case PIOP_AND:
+        case PIOP_OR:   case PIOP_RSH:  case PIOP_LSH:  case PIOP_RTL:
+        case PIOP_ARS:
+            return C == 0;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Explores the procedure starting at `entry`, running at call depth `depth`.
+ * Returns the extra call depth reached below it, or -1 on failure.
+ */
+static int explore(
+    struct verifier_t *verifier,
+    uint16_t entry,
+    uint8_t depth,
+    uint64_t visited[MAX_PROGRAM_LEN / 64]
+) {
+    uint16_t *worklist = verifier->worklist[depth];
+    uint16_t worklist_len = 0;
+    int height = 0;
+
+    worklist[worklist_len++] = entry;
+    visited[BITMAP_WORD(entry)] |= BITMAP_MASK(entry);
+
+    while(worklist_len > 0) {
+        const uint16_t inst_ptr = worklist[--worklist_len];
+        const uint16_t instruction = verifier->program[inst_ptr];
+
+        uint16_t next[2];
+        uint16_t next_len = 0;
+
+        if(writes_r0(instruction)) { return fail(verifier, inst_ptr); }
+
+        switch((enum pi_opcode_t)(instruction >> 11)) {
+            case PIOP_HLT:
+                /* `inst_ptr` is still incremented once */
+                if(inst_ptr + 1 >= MAX_PROGRAM_LEN) {
+                    return fail(verifier, inst_ptr);
+                }
+                break;
+            case PIOP_JMP:
+                next[next_len++] = (instruction & 0x07FF) + 1;
+                break;
+            case PIOP_BRH:
+                next[next_len++] = inst_ptr + 1;
+                next[next_len++] =
+                    ((inst_ptr & 0x700) | (instruction & 0xFF)) + 1;
+                break;
+            case PIOP_CALL: {
+                const uint16_t callee = (instruction & 0x07FF) + 1;
+
+                if(callee >= MAX_PROGRAM_LEN || depth + 1 >= CALLSTACK_LEN) {
+                    return fail(verifier, inst_ptr);
+                }
+
+                if(verifier->height[callee] == HEIGHT_UNKNOWN) {
+                    uint64_t callee_visited[MAX_PROGRAM_LEN / 64] = { 0 };
+
+                    const int callee_height = explore(
+                        verifier, callee, depth + 1, callee_visited
+                    );
+                    if(callee_height < 0) { return -1; }
+
+                    verifier->height[callee] = callee_height;
+                }
+
+                if(depth + 1 + verifier->height[callee] >= CALLSTACK_LEN) {
+                    return fail(verifier, inst_ptr);
+                }
+
+                if(height < 1 + verifier->height[callee]) {
+                    height = 1 + verifier->height[callee];
+                }
+
+                next[next_len++] = inst_ptr + 1;
+                break;
+            }
+            case PIOP_RET:
+                if(depth == 0) { return fail(verifier, inst_ptr); }
+                break;
+            default:
+                next[next_len++] = inst_ptr + 1;
+                break;
+        }
+
+        for(uint16_t i = 0; i < next_len; ++i) {
+            if(next[i] >= MAX_PROGRAM_LEN) { return fail(verifier, inst_ptr); }
+
+            if((visited[BITMAP_WORD(next[i])] & BITMAP_MASK(next[i])) != 0) {
+                continue;
+            }
+
+            visited[BITMAP_WORD(next[i])] |= BITMAP_MASK(next[i]);
+            worklist[worklist_len++] = next[i];
+        }
+    }
+
+    return height;
+}
+
+void pi_verify_program(
+    const uint16_t program[MAX_PROGRAM_LEN],
+    struct pi_proof_t *proof
+) {
+    if(!program) { PLG_FATAL("verify_program: program is NULL"); }
+    if(!proof)   { PLG_FATAL("verify_program: proof is NULL"); }
+
+    memset(proof, 0x00, sizeof(*proof));
+
+    struct verifier_t *verifier = malloc(sizeof(*verifier));
+    if(!verifier) { PLG_FATAL("verify_program: out of memory"); }
+
+    verifier->proof = proof;
+    verifier->program = program;
+    memset(verifier->height, HEIGHT_UNKNOWN, sizeof(verifier->height));
+
+    const int height = explore(verifier, 0, 0, proof->toplevel);
+
+    if(height >= 0) {
+        proof->verified = 1;
+        proof->max_call_depth = height;
+    } else {
+        memset(proof->toplevel, 0x00, sizeof(proof->toplevel));
+
+        PLG_INFO(
+            "verify_program: rejected at instruction %u, using the safe path",
+            proof->failed_at
+        );
+    }
+
+    free(verifier);
+}